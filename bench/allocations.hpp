@@ -0,0 +1,81 @@
+#ifndef _PROP_BENCH_ALLOCATIONS
+#define _PROP_BENCH_ALLOCATIONS
+
+/*
+ * Heap accounting for benchmarks: replaces the global allocation functions
+ * with versions that count allocations and their usable sizes
+ * (malloc_usable_size, so allocator rounding is included). Every benchmark
+ * binary is a single translation unit; include this header in at most one.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include <malloc.h>
+
+namespace bench {
+namespace heap {
+inline std::atomic<std::uint64_t> allocations{0};
+inline std::atomic<std::uint64_t> allocated{0};
+
+inline void *counted(void *p) {
+  if (p == nullptr)
+    throw std::bad_alloc();
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  allocated.fetch_add(malloc_usable_size(p), std::memory_order_relaxed);
+  return p;
+}
+} // namespace heap
+
+/*
+ * Allocations and allocated bytes since the start of the program; subtract
+ * two samples to measure a region.
+ */
+struct usage {
+  static usage now() {
+    return {heap::allocations.load(std::memory_order_relaxed),
+            heap::allocated.load(std::memory_order_relaxed)};
+  }
+  usage operator-(const usage &other) const {
+    return {count - other.count, bytes - other.bytes};
+  }
+  std::uint64_t count;
+  std::uint64_t bytes;
+};
+} // namespace bench
+
+// GCC matches inlined replacements against the builtin operator new and
+// reports free() as mismatched
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void *operator new(std::size_t n) {
+  return bench::heap::counted(std::malloc(n ? n : 1));
+}
+void *operator new[](std::size_t n) {
+  return bench::heap::counted(std::malloc(n ? n : 1));
+}
+void *operator new(std::size_t n, std::align_val_t a) {
+  std::size_t align = static_cast<std::size_t>(a);
+  return bench::heap::counted(
+      std::aligned_alloc(align, (n + align - 1) / align * align));
+}
+void *operator new[](std::size_t n, std::align_val_t a) {
+  return operator new(n, a);
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+#pragma GCC diagnostic pop
+
+#endif /* _PROP_BENCH_ALLOCATIONS */
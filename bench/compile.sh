@@ -0,0 +1,113 @@
+#!/bin/sh
+# Compile-time and code-size benchmark: generates synthetic translation units
+# that instantiate the library for many distinct types, compiles each one and
+# reports the compile time, the object size (text section and file) and the
+# amount of defined symbols (a proxy for instantiations). Subtract the
+# "baseline" row (the headers alone) to get the cost of the instantiations.
+#
+# Usage: ./compile.sh [--csv] [--types <n>] [--repeat <n>]
+#   --csv         print comma-separated values instead of a table
+#   --types <n>   distinct types per translation unit (default 200)
+#   --repeat <n>  compile each unit n times and keep the fastest (default 1)
+#
+# CXX and CXXFLAGS select the compiler and flags (default: g++, -O2).
+
+set -e
+
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--O2}
+CSV=0
+TYPES=200
+REPEAT=1
+
+while [ $# -gt 0 ]; do
+  case "$1" in
+    --csv) CSV=1 ;;
+    --types) shift; TYPES=$1 ;;
+    --repeat) shift; REPEAT=$1 ;;
+    *) echo "$0: ignoring unknown argument $1" >&2 ;;
+  esac
+  shift
+done
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+OUT=$HERE/bin/compile
+mkdir -p "$OUT"
+
+# Writes the unit for a scenario: the includes, TYPES distinct structs, and a
+# function per type whose body is the scenario's use of that type.
+generate() {
+  scenario=$1
+  file=$OUT/$scenario.cpp
+  {
+    echo '#include "event.hpp"'
+    echo '#include "property.hpp"'
+    echo
+    i=0
+    while [ "$i" -lt "$TYPES" ] && [ "$scenario" != baseline ]; do
+      echo "struct t$i { int a; double b; };"
+      echo "int use$i(int x) {"
+      case "$scenario" in
+        event)
+          echo "  properties::event<t$i> e;"
+          echo "  int sum = 0;"
+          echo "  auto f = [&sum](t$i v) { sum += v.a; };"
+          echo "  e + f;"
+          echo "  e.trigger(t$i{x, 0});"
+          echo "  return sum;" ;;
+        property)
+          echo "  properties::property<t$i, true> p(t$i{0, 0});"
+          echo "  int sum = 0;"
+          echo "  p + [&sum](t$i &v) { sum += v.a; };"
+          echo "  p.set(t$i{x, 0});"
+          echo "  return sum;" ;;
+        property-ref)
+          echo "  t$i value{0, 0};"
+          echo "  properties::property<t$i> p(value);"
+          echo "  int sum = 0;"
+          echo "  p + [&sum](t$i &v) { sum += v.a; };"
+          echo "  p.set(t$i{x, 0});"
+          echo "  return sum;" ;;
+      esac
+      echo "}"
+      i=$((i + 1))
+    done
+  } > "$file"
+  echo "$file"
+}
+
+now() { date +%s.%N; }
+
+if [ "$CSV" = 1 ]; then
+  echo "scenario,types,seconds,text_bytes,object_bytes,symbols"
+else
+  printf '%-14s %6s %9s %11s %12s %8s\n' scenario types seconds text object \
+    symbols
+fi
+
+for scenario in baseline event property property-ref; do
+  src=$(generate "$scenario")
+  obj=${src%.cpp}.o
+  best=
+  r=0
+  while [ "$r" -lt "$REPEAT" ]; do
+    start=$(now)
+    $CXX -std=c++17 $CXXFLAGS -I"$HERE/../inc" -c "$src" -o "$obj"
+    end=$(now)
+    best=$(awk -v s="$start" -v e="$end" -v b="$best" \
+      'BEGIN { t = e - s; print (b == "" || t < b) ? t : b }')
+    r=$((r + 1))
+  done
+  text=$(size -A "$obj" |
+    awk '$1 ~ /^\.text/ { sum += $2 } END { print sum + 0 }')
+  bytes=$(wc -c < "$obj")
+  symbols=$(nm --defined-only "$obj" | wc -l)
+  types=$TYPES
+  [ "$scenario" = baseline ] && types=0
+  if [ "$CSV" = 1 ]; then
+    echo "$scenario,$types,$best,$text,$bytes,$symbols"
+  else
+    printf '%-14s %6s %9.3f %11s %12s %8s\n' "$scenario" "$types" "$best" \
+      "$text" "$bytes" "$symbols"
+  fi
+done
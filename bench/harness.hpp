@@ -0,0 +1,271 @@
+#ifndef _PROP_BENCH_HARNESS
+#define _PROP_BENCH_HARNESS
+
+/*
+ * Minimal benchmark harness: runs a scenario in a loop and reports ns/op
+ * next to per-operation hardware counter deltas, read through
+ * perf_event_open(2). Counters that can't be opened (no PMU in a VM,
+ * perf_event_paranoid too strict, seccomp) are reported as "-"; the timings
+ * are always available.
+ *
+ * Indirect branch misses have no generic perf event; set
+ * PROP_BENCH_INDIRECT_EVENT to the raw event code of your CPU (e.g. 0x80c5
+ * for BR_MISP_RETIRED.INDIRECT on recent Intel cores) to count them.
+ *
+ * Every benchmark binary accepts:
+ *   --csv            print comma-separated values instead of a table
+ *   --filter <text>  only run scenarios whose name contains <text>
+ *   --min-ms <n>     minimum measuring time per scenario (default 200)
+ *   --threads <n>    maximum thread count for multi-threaded suites (default:
+ *                    the amount of hardware threads)
+ *   --param <k>=<v>  suite-specific setting (see the top of each suite)
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace bench {
+/*
+ * Keeps the compiler from optimizing a value (and its computation) away.
+ */
+template <typename T> inline void keep(T &&value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/*
+ * Keeps the compiler from assuming anything about memory.
+ */
+inline void clobber() { asm volatile("" : : : "memory"); }
+
+/*
+ * A set of hardware counters of the calling thread, each opened separately
+ * so one unsupported counter doesn't disable the others.
+ */
+struct counters {
+  static constexpr std::size_t count = 7;
+  static constexpr const char *names[count] = {
+      "cycles",    "instr",   "L1D-miss", "LLC-miss",
+      "branches", "br-miss", "ind-miss"};
+
+  counters() {
+    open_counter(0, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    open_counter(1, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    open_counter(2, PERF_TYPE_HW_CACHE,
+                 PERF_COUNT_HW_CACHE_L1D |
+                     (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                     (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    open_counter(3, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    open_counter(4, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS);
+    open_counter(5, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    if (const char *raw = std::getenv("PROP_BENCH_INDIRECT_EVENT"))
+      open_counter(6, PERF_TYPE_RAW, std::strtoull(raw, nullptr, 0));
+  }
+
+  counters(const counters &) = delete;
+
+  void start() {
+    for (int fd : fds)
+      if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+  }
+
+  // Stops counting; entries are -1 for counters that aren't available.
+  void stop(double (&values)[count]) {
+    for (std::size_t i = 0; i < count; i++) {
+      values[i] = -1;
+      if (fds[i] < 0)
+        continue;
+      ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+      std::uint64_t value = 0;
+      if (read(fds[i], &value, sizeof(value)) == sizeof(value))
+        values[i] = static_cast<double>(value);
+    }
+  }
+
+  bool any() const {
+    return std::any_of(std::begin(fds), std::end(fds),
+                       [](int fd) { return fd >= 0; });
+  }
+
+  ~counters() {
+    for (int fd : fds)
+      if (fd >= 0)
+        close(fd);
+  }
+
+private:
+  void open_counter(std::size_t i, std::uint32_t type, std::uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fds[i] = static_cast<int>(
+        syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  int fds[count] = {-1, -1, -1, -1, -1, -1, -1};
+};
+
+/*
+ * The result of a scenario; counter values are per operation (-1 if not
+ * available).
+ */
+struct result {
+  std::string name;
+  std::uint64_t iterations;
+  double ns_per_op;
+  double per_op[counters::count];
+};
+
+/*
+ * Command line options shared by all benchmark binaries.
+ */
+struct options {
+  options(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      if (arg == "--csv")
+        csv = true;
+      else if (arg == "--filter" && i + 1 < argc)
+        filter = argv[++i];
+      else if (arg == "--min-ms" && i + 1 < argc)
+        min_ms = std::atoi(argv[++i]);
+      else if (arg == "--threads" && i + 1 < argc)
+        max_threads = static_cast<unsigned>(std::atoi(argv[++i]));
+      else if (arg == "--param" && i + 1 < argc &&
+               std::strchr(argv[i + 1], '=') != nullptr)
+        params.push_back(argv[++i]);
+      else
+        std::fprintf(stderr, "%s: ignoring unknown argument %s\n", argv[0],
+                     argv[i]);
+    }
+  }
+
+  bool selected(const std::string &name) const {
+    return filter.empty() || name.find(filter) != std::string::npos;
+  }
+
+  /*
+   * Gets a suite-specific setting, or `fallback` if it wasn't given.
+   */
+  double param(const std::string &key, double fallback) const {
+    for (auto it = params.rbegin(); it != params.rend(); ++it)
+      if (it->compare(0, key.size() + 1, key + "=") == 0)
+        return std::atof(it->c_str() + key.size() + 1);
+    return fallback;
+  }
+
+  bool csv = false;
+  std::string filter;
+  int min_ms = 200;
+  unsigned max_threads = 0;
+  std::vector<std::string> params;
+};
+
+/*
+ * A suite of scenarios sharing one set of counters; prints each result as
+ * soon as it is measured.
+ */
+struct suite {
+  suite(int argc, char **argv) : opts{argc, argv} {}
+
+  /*
+   * Runs `op` repeatedly, doubling the amount of iterations until a batch
+   * takes at least `min_ms`, and reports the last batch. `op` is called with
+   * the index of the iteration.
+   */
+  template <typename F> void run(const std::string &name, F &&op) {
+    if (!opts.selected(name))
+      return;
+    for (std::uint64_t i = 0; i < 1000; i++)
+      op(i);
+
+    result r{name, 0, 0, {}};
+    for (std::uint64_t n = 1000;; n *= 2) {
+      hw.start();
+      auto start = std::chrono::steady_clock::now();
+      for (std::uint64_t i = 0; i < n; i++)
+        op(i);
+      auto end = std::chrono::steady_clock::now();
+      double totals[counters::count];
+      hw.stop(totals);
+      double ns = std::chrono::duration<double, std::nano>(end - start).count();
+      if (ns >= opts.min_ms * 1e6 || n >= (std::uint64_t{1} << 40)) {
+        r.iterations = n;
+        r.ns_per_op = ns / n;
+        for (std::size_t c = 0; c < counters::count; c++)
+          r.per_op[c] = totals[c] < 0 ? -1 : totals[c] / n;
+        break;
+      }
+    }
+    report(r);
+  }
+
+  /*
+   * Reports a result measured elsewhere (e.g. by a multi-threaded driver).
+   */
+  void report(const result &r) {
+    if (!printed_header)
+      print_header();
+    if (opts.csv) {
+      std::printf("%s,%llu,%.3f", r.name.c_str(),
+                  static_cast<unsigned long long>(r.iterations), r.ns_per_op);
+      for (double v : r.per_op)
+        v < 0 ? std::printf(",") : std::printf(",%.3f", v);
+      std::printf("\n");
+    } else {
+      std::printf("%-40s %10.2f", r.name.c_str(), r.ns_per_op);
+      for (double v : r.per_op)
+        v < 0 ? std::printf(" %9s", "-") : std::printf(" %9.2f", v);
+      std::printf("\n");
+    }
+    std::fflush(stdout);
+    results.push_back(r);
+  }
+
+  const options &settings() const { return opts; }
+  const std::vector<result> &all() const { return results; }
+
+private:
+  void print_header() {
+    printed_header = true;
+    if (opts.csv) {
+      std::printf("scenario,iterations,ns_per_op");
+      for (const char *n : counters::names)
+        std::printf(",%s", n);
+      std::printf("\n");
+      return;
+    }
+    if (!hw.any())
+      std::printf("# hardware counters unavailable; timings only\n");
+    std::printf("%-40s %10s", "scenario", "ns/op");
+    for (const char *n : counters::names)
+      std::printf(" %9s", n);
+    std::printf("\n");
+  }
+
+  options opts;
+  counters hw;
+  std::vector<result> results;
+  bool printed_header = false;
+};
+} // namespace bench
+
+#endif /* _PROP_BENCH_HARNESS */
@@ -0,0 +1,244 @@
+/*
+ * Comparison with other signal/slot libraries: the same scenarios written
+ * for properties::event / property and for each competitor found on the
+ * include path (Boost.Signals2, sigslot, entt's sigh; all header-only, pulled
+ * in through test/conanfile.txt). Scenario names end in the library, so
+ * `--csv` output can be pivoted per library:
+ *
+ *   emit/<n>                    trigger with n slots (0, 1, 10, 1000)
+ *   churn/connect+disconnect    connect a slot to a live signal and
+ *                               disconnect it again
+ *   churn/scoped-signal         create a signal, connect one slot, emit
+ *                               once and destroy it
+ *   property/set                update a value with one observer
+ *
+ * followed by the heap bytes and allocations per connection (1000 slots).
+ *
+ * properties::event can't disconnect a single callback, so it skips
+ * churn/connect+disconnect; churn/scoped-signal is the closest equivalent.
+ * Competitors model "property/set" as a plain value next to a signal.
+ */
+
+#include "../allocations.hpp"
+#include "../harness.hpp"
+
+#include "event.hpp"
+#include "property.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#if __has_include(<boost/signals2.hpp>)
+#include <boost/signals2.hpp>
+#define PROP_BENCH_BOOST
+#endif
+#if __has_include(<sigslot/signal.hpp>)
+#include <sigslot/signal.hpp>
+#define PROP_BENCH_SIGSLOT
+#endif
+#if __has_include(<entt/signal/sigh.hpp>)
+#include <entt/signal/sigh.hpp>
+#define PROP_BENCH_ENTT
+#endif
+
+namespace {
+int sink = 0;
+
+/*
+ * The slot used everywhere; entt needs distinct instances to connect the same
+ * member more than once.
+ */
+struct slot {
+  void on(int v) { sink += v + offset; }
+  void operator()(int v) { on(v); }
+  int offset = 0;
+};
+
+/*
+ * Every library is wrapped in an adapter with the same static interface:
+ * `signal`, `connect`, `emit` and (if supported) `disconnect`.
+ */
+struct ours {
+  static constexpr const char *name = "prop";
+  static constexpr bool can_disconnect = false;
+  using signal = properties::event<int>;
+  using connection = int;
+
+  static connection connect(signal &s, slot &target) {
+    auto callback = [&target](int v) { target.on(v); };
+    s + callback;
+    return 0;
+  }
+  static void emit(signal &s, int v) { s.trigger(v); }
+
+  struct property {
+    explicit property(slot &observer) {
+      value + [&observer](int &v) { observer.on(v); };
+    }
+    void set(int v) { value.set(v); }
+    properties::property<int, true> value{0};
+  };
+};
+
+template <typename Lib> struct observed {
+  explicit observed(slot &observer) { Lib::connect(changed, observer); }
+  void set(int v) {
+    value = v;
+    Lib::emit(changed, value);
+  }
+  int value = 0;
+  typename Lib::signal changed;
+};
+
+#ifdef PROP_BENCH_BOOST
+struct boost_signals2 {
+  static constexpr const char *name = "boost-signals2";
+  static constexpr bool can_disconnect = true;
+  using signal = boost::signals2::signal<void(int)>;
+  using connection = boost::signals2::connection;
+
+  static connection connect(signal &s, slot &target) {
+    return s.connect([&target](int v) { target.on(v); });
+  }
+  static void disconnect(signal &, connection &c) { c.disconnect(); }
+  static void emit(signal &s, int v) { s(v); }
+  using property = observed<boost_signals2>;
+};
+#endif
+
+#ifdef PROP_BENCH_SIGSLOT
+struct sigslot_lib {
+  static constexpr const char *name = "sigslot";
+  static constexpr bool can_disconnect = true;
+  using signal = sigslot::signal<int>;
+  using connection = sigslot::connection;
+
+  static connection connect(signal &s, slot &target) {
+    return s.connect([&target](int v) { target.on(v); });
+  }
+  static void disconnect(signal &, connection &c) { c.disconnect(); }
+  static void emit(signal &s, int v) { s(v); }
+  using property = observed<sigslot_lib>;
+};
+#endif
+
+#ifdef PROP_BENCH_ENTT
+struct entt_sigh {
+  static constexpr const char *name = "entt-sigh";
+  static constexpr bool can_disconnect = true;
+  using signal = entt::sigh<void(int)>;
+  using connection = entt::connection;
+
+  static connection connect(signal &s, slot &target) {
+    entt::sink sink{s};
+    return sink.template connect<&slot::on>(target);
+  }
+  static void disconnect(signal &, connection &c) { c.release(); }
+  static void emit(signal &s, int v) { s.publish(v); }
+  using property = observed<entt_sigh>;
+};
+#endif
+
+template <typename Lib> void timings(bench::suite &suite) {
+  const std::string suffix = std::string("/") + Lib::name;
+
+  for (std::size_t n : {0, 1, 10, 1000}) {
+    typename Lib::signal s;
+    std::vector<slot> slots(n);
+    for (std::size_t i = 0; i < n; i++) {
+      slots[i].offset = static_cast<int>(i);
+      Lib::connect(s, slots[i]);
+    }
+    suite.run("emit/" + std::to_string(n) + suffix, [&](std::uint64_t i) {
+      Lib::emit(s, static_cast<int>(i));
+    });
+  }
+
+  if constexpr (Lib::can_disconnect) {
+    typename Lib::signal s;
+    std::vector<slot> resident(10);
+    for (auto &r : resident)
+      Lib::connect(s, r);
+    slot target;
+    suite.run("churn/connect+disconnect" + suffix, [&](std::uint64_t) {
+      auto c = Lib::connect(s, target);
+      Lib::disconnect(s, c);
+    });
+  }
+
+  {
+    slot target;
+    suite.run("churn/scoped-signal" + suffix, [&](std::uint64_t i) {
+      typename Lib::signal s;
+      Lib::connect(s, target);
+      Lib::emit(s, static_cast<int>(i));
+    });
+  }
+
+  {
+    slot observer;
+    typename Lib::property p(observer);
+    suite.run("property/set" + suffix,
+              [&](std::uint64_t i) { p.set(static_cast<int>(i)); });
+  }
+}
+
+template <typename Lib> void footprint(const bench::options &opts) {
+  constexpr std::size_t n = 1000;
+  std::string name = std::string("memory/per-connection/") + Lib::name;
+  if (!opts.selected(name))
+    return;
+  std::vector<slot> slots(n);
+  std::vector<typename Lib::connection> connections;
+  connections.reserve(n);
+  auto start = bench::usage::now();
+  {
+    typename Lib::signal s;
+    for (auto &target : slots)
+      connections.push_back(Lib::connect(s, target));
+    auto used = bench::usage::now() - start;
+    double bytes = static_cast<double>(used.bytes) / n;
+    double count = static_cast<double>(used.count) / n;
+    if (opts.csv)
+      std::printf("%s,%zu,%zu,%.2f,%.2f\n", name.c_str(), n,
+                  sizeof(typename Lib::signal), bytes, count);
+    else
+      std::printf("%-40s %10zu %10zu %10.2f %10.2f\n", name.c_str(), n,
+                  sizeof(typename Lib::signal), bytes, count);
+  }
+}
+
+template <typename... Libs> void compare(bench::suite &suite) {
+  (timings<Libs>(suite), ...);
+  const auto &opts = suite.settings();
+  if (opts.csv)
+    std::printf("# memory per connection\n"
+                "scenario,connections,sizeof_signal,bytes,allocations\n");
+  else
+    std::printf("\n%-40s %10s %10s %10s %10s\n", "scenario", "slots",
+                "sizeof", "bytes", "allocs");
+  (footprint<Libs>(opts), ...);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::suite suite(argc, argv);
+  compare<ours
+#ifdef PROP_BENCH_BOOST
+          ,
+          boost_signals2
+#endif
+#ifdef PROP_BENCH_SIGSLOT
+          ,
+          sigslot_lib
+#endif
+#ifdef PROP_BENCH_ENTT
+          ,
+          entt_sigh
+#endif
+          >(suite);
+  bench::keep(sink);
+  return 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * Dispatch paths: event::trigger and property::set with various listener
+ * counts, closure sizes and instrumentation.
+ */
+
+#include "../harness.hpp"
+
+#include "event.hpp"
+#include "metrics.hpp"
+#include "property.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+using namespace properties;
+
+namespace {
+int sink = 0;
+
+void trigger_with(bench::suite &suite, std::size_t listeners) {
+  event<int> e;
+  for (std::size_t i = 0; i < listeners; i++) {
+    auto callback = [](int v) { sink += v; };
+    e + callback;
+  }
+  suite.run("event<int>::trigger/" + std::to_string(listeners),
+            [&e](std::uint64_t i) { e.trigger(static_cast<int>(i)); });
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::suite suite(argc, argv);
+
+  for (std::size_t n : {0, 1, 4, 16, 64})
+    trigger_with(suite, n);
+
+  {
+    event<int> e;
+    std::array<std::uint64_t, 8> state{};
+    auto callback = [state](int v) mutable { state[v & 7] += v; };
+    e + callback;
+    suite.run("event<int>::trigger/1/64-byte-closure",
+              [&e](std::uint64_t i) { e.trigger(static_cast<int>(i)); });
+  }
+
+  {
+    int value = 0;
+    property<int> p(value);
+    suite.run("property<int>::set/0",
+              [&p](std::uint64_t i) { p.set(static_cast<int>(i)); });
+    p + [](int &v) { sink += v; };
+    suite.run("property<int>::set/1",
+              [&p](std::uint64_t i) { p.set(static_cast<int>(i)); });
+  }
+
+  {
+    property<int, true> p(0);
+    p + [](int &v) { sink += v; };
+    suite.run("property<int,true>::set/1",
+              [&p](std::uint64_t i) { p.set(static_cast<int>(i)); });
+  }
+
+  {
+    property<std::string, true> p("");
+    p + [](std::string &v) { sink += static_cast<int>(v.size()); };
+    std::string values[2] = {"a short string",
+                             "a string long enough to live on the heap"};
+    suite.run("property<string,true>::set/1", [&](std::uint64_t i) {
+      p.set(values[i & 1]);
+    });
+  }
+
+  {
+    property<int, true> p(0);
+    p + [](int &v) { sink += v; };
+    p.monitor_listeners(listener_policy{});
+    suite.run("property<int,true>::set/1/monitored",
+              [&p](std::uint64_t i) { p.set(static_cast<int>(i)); });
+  }
+
+  {
+    event_metrics metrics;
+    property<int, true> p(0);
+    p + [](int &v) { sink += v; };
+    p.attach_metrics(&metrics);
+    suite.run("property<int,true>::set/1/metrics",
+              [&p](std::uint64_t i) { p.set(static_cast<int>(i)); });
+  }
+
+  bench::keep(sink);
+  return 0;
+}
@@ -0,0 +1,307 @@
+/*
+ * End-to-end propagation through large synthetic dependency graphs. Every
+ * node is a property<int64_t, true>; every edge is a listener on its source
+ * that forwards the new value (plus one) to its target. Shapes:
+ *
+ *   powerlaw   preferential-attachment tree: power-law fan-out, shallow
+ *   chain      independent chains of `depth` nodes
+ *   diamond    stacks of `depth` diamonds (a -> b, c -> d); every join node
+ *              is reached twice per wave
+ *
+ * Each shape runs in every dispatch mode: plain, monitored (default listener
+ * policy), metrics (one event_metrics shared by all nodes) and async (every
+ * listener is demoted to a listener_pool after its first call).
+ *
+ * Writes come from a stream with tunable locality: a fraction `locality` of
+ * the writes hits a hot window of `hot` * nodes nodes, which slides through
+ * the graph; the rest is uniform. A write and everything it causes is one
+ * wave; the reported latency is per wave, and "updates" counts the nodes set
+ * by a wave (including the written one).
+ *
+ * Listeners don't set their target directly: that would recurse once per
+ * edge, and a deep chain would overflow the stack. They queue the target
+ * instead, and the driver sets queued nodes in FIFO order, so waves are
+ * breadth-first and a node is set at most once per wave. Every set still
+ * goes through the normal property notification path.
+ *
+ * Settings (--param key=value): nodes (default 1048576), depth (chain and
+ * diamond length, default 1000), locality (default 0.9), hot (default 0.01),
+ * pool (async worker threads, default 2), seed (default 1).
+ */
+
+#include "../allocations.hpp"
+#include "../harness.hpp"
+
+#include "metrics.hpp"
+#include "monitor.hpp"
+#include "property.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace properties;
+
+namespace {
+enum class mode { plain, monitored, metrics, async };
+constexpr const char *mode_names[] = {"plain", "monitored", "metrics",
+                                      "async"};
+
+struct settings {
+  explicit settings(const bench::options &opts)
+      : nodes{static_cast<std::uint32_t>(opts.param("nodes", 1 << 20))},
+        depth{std::max(1u, static_cast<std::uint32_t>(
+                               opts.param("depth", 1000)))},
+        locality{opts.param("locality", 0.9)}, hot{opts.param("hot", 0.01)},
+        pool{static_cast<std::size_t>(opts.param("pool", 2))},
+        seed{static_cast<std::uint64_t>(opts.param("seed", 1))} {}
+
+  std::uint32_t nodes;
+  std::uint32_t depth;
+  double locality;
+  double hot;
+  std::size_t pool;
+  std::uint64_t seed;
+};
+
+struct graph {
+  using value = std::int64_t;
+
+  explicit graph(std::uint32_t size) : stamp(size, 0) {
+    nodes.reserve(size);
+    for (std::uint32_t i = 0; i < size; i++)
+      nodes.emplace_back(0);
+  }
+
+  void connect(std::uint32_t from, std::uint32_t to) {
+    graph *self = this;
+    nodes[from] + [self, to](value &v) { self->enqueue(to, v + 1); };
+    edges++;
+  }
+
+  void enqueue(std::uint32_t node, value v) {
+    std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+    if (pool)
+      lock.lock();
+    if (stamp[node] == wave)
+      return;
+    stamp[node] = wave;
+    queue.emplace_back(node, v);
+  }
+
+  /*
+   * Writes a node and propagates; returns the amount of nodes set.
+   */
+  std::size_t propagate(std::uint32_t node, value v) {
+    wave++;
+    stamp[node] = wave;
+    nodes[node].set(v);
+    std::size_t updated = 1;
+    std::pair<std::uint32_t, value> next;
+    while (pop(next) || (pool && (pool->wait_idle(), pop(next)))) {
+      nodes[next.first].set(next.second);
+      updated++;
+    }
+    queue.clear();
+    head = 0;
+    return updated;
+  }
+
+  std::vector<property<value, true>> nodes;
+  std::size_t edges = 0;
+  listener_pool *pool = nullptr;
+
+private:
+  bool pop(std::pair<std::uint32_t, value> &next) {
+    std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+    if (pool)
+      lock.lock();
+    if (head == queue.size())
+      return false;
+    next = queue[head++];
+    return true;
+  }
+
+  std::vector<std::uint32_t> stamp;
+  std::uint32_t wave = 0;
+  std::vector<std::pair<std::uint32_t, value>> queue;
+  std::size_t head = 0;
+  std::mutex mutex;
+};
+
+void powerlaw(graph &g, std::mt19937_64 &rng) {
+  // each new node attaches to an endpoint of a random existing edge, so
+  // parents are picked in proportion to their degree
+  std::vector<std::uint32_t> endpoints{0};
+  for (std::uint32_t i = 1; i < g.nodes.size(); i++) {
+    std::uint32_t parent = endpoints[rng() % endpoints.size()];
+    g.connect(parent, i);
+    endpoints.push_back(parent);
+    endpoints.push_back(i);
+  }
+}
+
+void chain(graph &g, std::uint32_t depth) {
+  for (std::uint32_t i = 0; i + 1 < g.nodes.size(); i++)
+    if ((i + 1) % depth != 0)
+      g.connect(i, i + 1);
+}
+
+void diamond(graph &g, std::uint32_t depth) {
+  // node 3k is the top of diamond k of its stack, 3k + 1 and 3k + 2 its
+  // sides, and 3k + 3 its join (the top of the next one)
+  std::uint32_t stack = 3 * depth + 1;
+  for (std::uint32_t i = 0; i < g.nodes.size(); i++) {
+    std::uint32_t base = i - i % stack;
+    std::uint32_t k = i - base;
+    auto link = [&](std::uint32_t to) {
+      if (to - base < stack && to < g.nodes.size())
+        g.connect(i, to);
+    };
+    if (k % 3 == 0) {
+      link(i + 1);
+      link(i + 2);
+    } else {
+      link(i + 3 - k % 3);
+    }
+  }
+}
+
+std::vector<std::uint32_t> writes(const settings &s, std::mt19937_64 &rng) {
+  constexpr std::size_t length = 1 << 16;
+  std::uint32_t window =
+      std::max<std::uint32_t>(1, static_cast<std::uint32_t>(s.nodes * s.hot));
+  std::uint32_t start = 0;
+  std::uniform_real_distribution<double> coin(0, 1);
+  std::vector<std::uint32_t> out;
+  out.reserve(length);
+  for (std::size_t i = 0; i < length; i++) {
+    if (i % 1024 == 0)
+      start = (start + std::max(1u, window / 16)) % s.nodes;
+    if (coin(rng) < s.locality)
+      out.push_back((start + rng() % window) % s.nodes);
+    else
+      out.push_back(rng() % s.nodes);
+  }
+  return out;
+}
+
+double percentile(std::vector<double> &samples, double q) {
+  if (samples.empty())
+    return 0;
+  std::size_t k = static_cast<std::size_t>(q * (samples.size() - 1));
+  std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+  return samples[k];
+}
+
+void header(const bench::options &opts) {
+  if (opts.csv)
+    std::printf("scenario,nodes,edges,bytes_per_node,writes_per_s,"
+                "updates_per_s,wave_size,p50_us,p99_us,p999_us\n");
+  else
+    std::printf("%-20s %9s %9s %8s %10s %10s %9s %9s %9s %9s\n", "scenario",
+                "nodes", "edges", "B/node", "writes/s", "updates/s", "wave",
+                "p50 us", "p99 us", "p999 us");
+}
+
+void run(const bench::options &opts, const settings &s,
+         const std::string &shape, mode m) {
+  std::string name = shape + "/" + mode_names[static_cast<int>(m)];
+  if (!opts.selected(name))
+    return;
+  std::mt19937_64 rng(s.seed);
+
+  event_metrics metrics;
+  std::unique_ptr<listener_pool> pool;
+  if (m == mode::async)
+    pool = std::make_unique<listener_pool>(s.pool);
+
+  auto before = bench::usage::now();
+  {
+    graph g(s.nodes);
+    if (shape == "powerlaw")
+      powerlaw(g, rng);
+    else if (shape == "chain")
+      chain(g, s.depth);
+    else
+      diamond(g, s.depth);
+
+    listener_policy policy;
+    if (m == mode::async) {
+      policy.budget = std::chrono::nanoseconds(0);
+      policy.strikes = 1;
+      policy.pool = pool.get();
+      g.pool = pool.get();
+    }
+    for (auto &node : g.nodes) {
+      if (m == mode::monitored || m == mode::async)
+        node.monitor_listeners(policy);
+      else if (m == mode::metrics)
+        node.attach_metrics(&metrics);
+    }
+    auto used = bench::usage::now() - before;
+
+    auto stream = writes(s, rng);
+    for (std::size_t i = 0; i < std::min<std::size_t>(stream.size(), 4096);
+         i++)
+      g.propagate(stream[i], static_cast<graph::value>(i));
+
+    std::vector<double> latencies;
+    latencies.reserve(1 << 20);
+    std::uint64_t waves = 0;
+    std::uint64_t updates = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(opts.min_ms);
+    auto now = start;
+    while (now < deadline) {
+      std::uint32_t node = stream[waves % stream.size()];
+      updates += g.propagate(node, static_cast<graph::value>(waves));
+      auto end = std::chrono::steady_clock::now();
+      if (latencies.size() < latencies.capacity())
+        latencies.push_back(
+            std::chrono::duration<double, std::micro>(end - now).count());
+      now = end;
+      waves++;
+    }
+    double seconds = std::chrono::duration<double>(now - start).count();
+    double per_node = static_cast<double>(used.bytes) / s.nodes;
+
+    double p50 = percentile(latencies, 0.5);
+    double p99 = percentile(latencies, 0.99);
+    double p999 = percentile(latencies, 0.999);
+    if (opts.csv)
+      std::printf("%s,%u,%zu,%.1f,%.0f,%.0f,%.2f,%.3f,%.3f,%.3f\n",
+                  name.c_str(), s.nodes, g.edges, per_node, waves / seconds,
+                  updates / seconds, static_cast<double>(updates) / waves,
+                  p50, p99, p999);
+    else
+      std::printf("%-20s %9u %9zu %8.1f %10.0f %10.0f %9.2f %9.3f %9.3f "
+                  "%9.3f\n",
+                  name.c_str(), s.nodes, g.edges, per_node, waves / seconds,
+                  updates / seconds, static_cast<double>(updates) / waves,
+                  p50, p99, p999);
+    std::fflush(stdout);
+  }
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::options opts(argc, argv);
+  settings s(opts);
+  if (s.nodes == 0) {
+    std::fprintf(stderr, "%s: nodes must be positive\n", argv[0]);
+    return 1;
+  }
+  header(opts);
+  for (const char *shape : {"powerlaw", "chain", "diamond"})
+    for (mode m : {mode::plain, mode::monitored, mode::metrics, mode::async})
+      run(opts, s, shape, m);
+  return 0;
+}
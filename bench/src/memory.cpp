@@ -0,0 +1,206 @@
+/*
+ * Memory footprint and allocations: bytes per property, bytes and heap
+ * allocations per listener across closure sizes and listener counts, and
+ * heap allocations per operation in steady state. Heap bytes are usable
+ * sizes (malloc_usable_size), so they include allocator rounding.
+ *
+ * The steady-state operations that should never allocate are checked; the
+ * binary exits with status 1 (failing `make bench`) if one of them does.
+ */
+
+#include "../allocations.hpp"
+#include "../harness.hpp"
+
+#include "event.hpp"
+#include "memoized.hpp"
+#include "metrics.hpp"
+#include "property.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace properties;
+
+namespace {
+int sink = 0;
+
+using bench::usage;
+
+template <std::size_t N> struct closure {
+  std::array<char, N> data{};
+  void operator()(int &v) const { sink += data[0] + v; }
+};
+
+struct report {
+  explicit report(const bench::options &opts) : opts{opts} {}
+
+  void section(const char *title, const char *columns) {
+    if (opts.csv)
+      std::printf("# %s\n%s\n", title, columns);
+    else
+      std::printf("\n== %s\n", title);
+  }
+
+  void row(const std::string &name, std::uint64_t count, double a, double b) {
+    if (!opts.selected(name))
+      return;
+    if (opts.csv)
+      std::printf("%s,%llu,%.2f,%.2f\n", name.c_str(),
+                  static_cast<unsigned long long>(count), a, b);
+    else
+      std::printf("%-48s %8llu %12.2f %12.2f\n", name.c_str(),
+                  static_cast<unsigned long long>(count), a, b);
+  }
+
+  const bench::options &opts;
+};
+
+template <std::size_t N>
+void listeners(report &out, const std::string &label) {
+  for (std::size_t count : {1, 4, 16, 64, 1024}) {
+    property<int, true> p(0);
+    auto start = usage::now();
+    for (std::size_t i = 0; i < count; i++)
+      p + closure<N>{};
+    auto used = usage::now() - start;
+    out.row("listener/" + label + "/" + std::to_string(count), count,
+            static_cast<double>(used.bytes) / count,
+            static_cast<double>(used.count) / count);
+  }
+}
+
+/*
+ * Allocations per operation after a warm-up; returns false if `must_be_zero`
+ * and the operation allocated.
+ */
+template <typename F>
+bool per_op(report &out, const std::string &name, bool must_be_zero, F &&op) {
+  constexpr std::uint64_t n = 10000;
+  for (std::uint64_t i = 0; i < 100; i++)
+    op(i);
+  auto start = usage::now();
+  for (std::uint64_t i = 0; i < n; i++)
+    op(i);
+  auto used = usage::now() - start;
+  out.row(name, n, static_cast<double>(used.count) / n,
+          static_cast<double>(used.bytes) / n);
+  if (must_be_zero && used.count != 0) {
+    std::fprintf(stderr, "# regression: %s allocates in steady state\n",
+                 name.c_str());
+    return false;
+  }
+  return true;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::options opts(argc, argv);
+  report out(opts);
+
+  out.section("bytes per property: sizeof, heap bytes with 0 / 1 listener",
+              "type,sizeof,heap_empty,heap_one_listener");
+  // heap bytes right after construction, and after adding one listener
+  auto footprint = [&](const std::string &name, auto make, auto subscribe) {
+    auto start = usage::now();
+    auto node = make();
+    auto empty = usage::now() - start;
+    subscribe(node);
+    auto one = usage::now() - start;
+    out.row(name, sizeof(node), static_cast<double>(empty.bytes),
+            static_cast<double>(one.bytes));
+  };
+  auto add_closure = [](auto &prop) { prop + closure<1>{}; };
+  int value = 0;
+  footprint(
+      "property/int", [&value]() { return property<int>(value); },
+      add_closure);
+  footprint(
+      "property/int,true", []() { return property<int, true>(0); },
+      add_closure);
+  footprint(
+      "event<int>", []() { return event<int>(); },
+      [](event<int> &e) {
+        auto callback = [](int v) { sink += v; };
+        e + callback;
+      });
+
+  out.section("bytes per listener: heap bytes / allocations per listener",
+              "scenario,listeners,bytes,allocations");
+  listeners<1>(out, "empty-closure");
+  listeners<8>(out, "8-byte-closure");
+  listeners<16>(out, "16-byte-closure");
+  listeners<24>(out, "24-byte-closure");
+  listeners<32>(out, "32-byte-closure");
+  listeners<64>(out, "64-byte-closure");
+  listeners<128>(out, "128-byte-closure");
+
+  out.section("allocations per operation (steady state)",
+              "scenario,operations,allocations,bytes");
+  bool ok = true;
+  {
+    event<int> e;
+    for (int i = 0; i < 4; i++) {
+      auto callback = [](int v) { sink += v; };
+      e + callback;
+    }
+    ok &= per_op(out, "event<int>::trigger/4", true,
+                 [&](std::uint64_t i) { e.trigger(static_cast<int>(i)); });
+  }
+  {
+    property<int, true> p(0);
+    p + closure<16>{};
+    ok &= per_op(out, "property<int,true>::set/16-byte-closure", true,
+                 [&](std::uint64_t i) { p.set(static_cast<int>(i)); });
+  }
+  {
+    property<int, true> p(0);
+    p + closure<64>{};
+    ok &= per_op(out, "property<int,true>::set/64-byte-closure", true,
+                 [&](std::uint64_t i) { p.set(static_cast<int>(i)); });
+  }
+  {
+    property<int, true> p(0);
+    p + closure<1>{};
+    p.monitor_listeners(listener_policy{});
+    ok &= per_op(out, "property<int,true>::set/monitored", true,
+                 [&](std::uint64_t i) { p.set(static_cast<int>(i)); });
+  }
+  {
+    event_metrics metrics;
+    property<int, true> p(0);
+    p + closure<1>{};
+    p.attach_metrics(&metrics);
+    ok &= per_op(out, "property<int,true>::set/metrics", true,
+                 [&](std::uint64_t i) { p.set(static_cast<int>(i)); });
+  }
+  {
+    property<std::string, true> p("");
+    std::string values[2] = {"short", "a string long enough for the heap"};
+    ok &= per_op(out, "property<string,true>::set/alternating", false,
+                 [&](std::uint64_t i) { p.set(values[i & 1]); });
+  }
+  {
+    int a = 0;
+    property<int> source(a);
+    memoized<int, int> square(64, [](int x) { return x * x; }, source);
+    ok &= per_op(out, "memoized<int,int>/update/64-distinct", false,
+                 [&](std::uint64_t i) {
+                   source.set(static_cast<int>(i & 63));
+                 });
+  }
+  {
+    ok &= per_op(out, "event<int>/construct+subscribe+destroy", false,
+                 [](std::uint64_t i) {
+                   event<int> e;
+                   auto callback = [](int v) { sink += v; };
+                   e + callback;
+                   e.trigger(static_cast<int>(i));
+                 });
+  }
+
+  bench::keep(sink);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,258 @@
+/*
+ * Scalability: every concurrent feature from 1 to N threads, each thread
+ * pinned to its own CPU. Reports throughput and p50/p99/p999 latency per
+ * thread count, plus a false-sharing check comparing writers on adjacent
+ * (packed) properties with writers on cache-line padded ones.
+ *
+ * Latencies are measured over batches of 16 operations (divided by 16), so
+ * the clock overhead stays small compared to the operations.
+ *
+ * Events don't support removing listeners and aren't safe to subscribe to
+ * concurrently, so "churn" builds, uses and destroys a thread-confined event
+ * per operation; that still stresses the allocator behind the listener
+ * storage.
+ */
+
+#include "../harness.hpp"
+
+#include "event.hpp"
+#include "property.hpp"
+#include "shared_value.hpp"
+#include "thread_local.hpp"
+#include "transaction.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+using namespace properties;
+
+namespace {
+thread_local std::uint64_t sink = 0;
+
+constexpr std::uint64_t batch = 16;
+constexpr std::size_t max_samples = 1 << 20;
+
+struct outcome {
+  double mops;
+  double p50;
+  double p99;
+  double p999;
+};
+
+void pin(unsigned cpu) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu % std::max(1u, std::thread::hardware_concurrency()), &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+double percentile(std::vector<double> &samples, double q) {
+  if (samples.empty())
+    return 0;
+  std::size_t k = static_cast<std::size_t>(q * (samples.size() - 1));
+  std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+  return samples[k];
+}
+
+/*
+ * Runs op(thread, i) on `threads` pinned threads for `ms` milliseconds.
+ */
+template <typename Op> outcome drive(unsigned threads, int ms, Op &&op) {
+  std::atomic<unsigned> ready{0};
+  std::atomic<bool> go{false};
+  std::atomic<bool> stop{false};
+  std::vector<std::vector<double>> latencies(threads);
+  std::vector<std::uint64_t> ops(threads, 0);
+  std::vector<std::thread> workers;
+
+  for (unsigned t = 0; t < threads; t++)
+    workers.emplace_back([&, t]() {
+      pin(t);
+      auto &samples = latencies[t];
+      samples.reserve(max_samples);
+      ready++;
+      while (!go.load(std::memory_order_acquire))
+        ;
+      std::uint64_t n = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::uint64_t k = 0; k < batch; k++)
+          op(t, n + k);
+        auto end = std::chrono::steady_clock::now();
+        if (samples.size() < max_samples)
+          samples.push_back(
+              std::chrono::duration<double, std::nano>(end - start).count() /
+              batch);
+        n += batch;
+      }
+      ops[t] = n;
+    });
+
+  while (ready.load() != threads)
+    std::this_thread::yield();
+  auto start = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  stop = true;
+  for (auto &w : workers)
+    w.join();
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  std::vector<double> all;
+  std::uint64_t total = 0;
+  for (unsigned t = 0; t < threads; t++) {
+    all.insert(all.end(), latencies[t].begin(), latencies[t].end());
+    total += ops[t];
+  }
+  return {total / seconds / 1e6, percentile(all, 0.5), percentile(all, 0.99),
+          percentile(all, 0.999)};
+}
+
+struct table {
+  explicit table(const bench::options &opts) : opts{opts} {
+    if (opts.csv)
+      std::printf("scenario,threads,mops,p50_ns,p99_ns,p999_ns\n");
+    else
+      std::printf("%-36s %7s %10s %9s %9s %9s\n", "scenario", "threads",
+                  "Mops/s", "p50", "p99", "p999");
+  }
+
+  void row(const std::string &name, unsigned threads, const outcome &o) {
+    if (opts.csv)
+      std::printf("%s,%u,%.3f,%.1f,%.1f,%.1f\n", name.c_str(), threads, o.mops,
+                  o.p50, o.p99, o.p999);
+    else
+      std::printf("%-36s %7u %10.2f %9.1f %9.1f %9.1f\n", name.c_str(),
+                  threads, o.mops, o.p50, o.p99, o.p999);
+    std::fflush(stdout);
+  }
+
+  const bench::options &opts;
+};
+
+template <typename T> struct alignas(64) padded {
+  T value;
+};
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::options opts(argc, argv);
+  unsigned max_threads = opts.max_threads;
+  if (max_threads == 0)
+    max_threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<unsigned> counts;
+  for (unsigned n = 1; n < max_threads; n *= 2)
+    counts.push_back(n);
+  counts.push_back(max_threads);
+
+  if (!opts.csv) {
+    std::printf("# layout: property<int,true> %zu bytes (%.2f per cache "
+                "line), event<int> %zu bytes, property<int> %zu bytes\n",
+                sizeof(property<int, true>),
+                64.0 / sizeof(property<int, true>),
+                sizeof(event<int>), sizeof(property<int>));
+  }
+  table out(opts);
+  auto scenario = [&](const std::string &name, auto &&make) {
+    if (!opts.selected(name))
+      return std::vector<outcome>{};
+    std::vector<outcome> results;
+    for (unsigned n : counts) {
+      auto op = make(n);
+      results.push_back(drive(n, opts.min_ms, op));
+      out.row(name, n, results.back());
+    }
+    return results;
+  };
+
+  event<int> shared;
+  for (int i = 0; i < 4; i++) {
+    auto callback = [](int v) { sink += v; };
+    shared + callback;
+  }
+  scenario("trigger/shared-event/4", [&](unsigned) {
+    return [&](unsigned, std::uint64_t i) {
+      shared.trigger(static_cast<int>(i));
+    };
+  });
+
+  scenario("churn/event+4-listeners", [](unsigned) {
+    return [](unsigned, std::uint64_t i) {
+      event<int> e;
+      for (int k = 0; k < 4; k++) {
+        auto callback = [k](int v) { sink += v + k; };
+        e + callback;
+      }
+      e.trigger(static_cast<int>(i));
+    };
+  });
+
+  shared_value_property<std::uint64_t> snapshot(0);
+  scenario("readers/shared_value::read", [&](unsigned) {
+    return [&](unsigned, std::uint64_t) {
+      sink += snapshot.read([](const std::uint64_t &v) { return v; });
+    };
+  });
+  scenario("readers/shared_value::get", [&](unsigned) {
+    return [&](unsigned, std::uint64_t) { sink += *snapshot.get(); };
+  });
+
+  tx_domain domain;
+  tx_property<std::uint64_t> versioned(domain, 0);
+  scenario("readers/read_transaction", [&](unsigned) {
+    return [&](unsigned, std::uint64_t) {
+      read_transaction tx(domain);
+      sink += tx.get(versioned);
+    };
+  });
+
+  thread_local_property<std::uint64_t> counter(0);
+  scenario("writers/thread_local_property", [&](unsigned) {
+    return [&](unsigned, std::uint64_t) {
+      counter.update_local([](std::uint64_t v) { return v + 1; });
+    };
+  });
+
+  std::vector<property<int, true>> packed;
+  auto packed_results = scenario("writers/packed-properties", [&](unsigned n) {
+    packed.assign(n, property<int, true>(0));
+    for (unsigned t = 0; t < n; t++)
+      packed[t] + [](int &v) { sink += v; };
+    return [&](unsigned t, std::uint64_t i) {
+      packed[t].set(static_cast<int>(i));
+    };
+  });
+
+  std::vector<padded<property<int, true>>> spaced;
+  auto padded_results = scenario("writers/padded-properties", [&](unsigned n) {
+    spaced.assign(n, padded<property<int, true>>{property<int, true>(0)});
+    for (unsigned t = 0; t < n; t++)
+      spaced[t].value + [](int &v) { sink += v; };
+    return [&](unsigned t, std::uint64_t i) {
+      spaced[t].value.set(static_cast<int>(i));
+    };
+  });
+
+  for (std::size_t i = 0;
+       i < std::min(packed_results.size(), padded_results.size()); i++) {
+    if (counts[i] == 1)
+      continue;
+    double ratio = packed_results[i].mops / padded_results[i].mops;
+    std::fprintf(opts.csv ? stderr : stdout,
+                 "# false sharing at %u threads: packed/padded throughput "
+                 "%.2f%s\n",
+                 counts[i], ratio, ratio < 0.8 ? " (suspect)" : "");
+  }
+  return 0;
+}
@@ -0,0 +1,180 @@
+#ifndef _PROP_ANY_PROPERTY
+#define _PROP_ANY_PROPERTY
+
+#include "property.hpp"
+#include "serialize.hpp"
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ *  @brief Identifier of a type, unique per type within a program.
+ */
+using type_id = const void *;
+
+/**
+ * @brief Implementation details; not part of the public interface.
+ */
+namespace detail {
+template <typename T> struct type_tag {
+  static constexpr char id = 0;
+};
+} // namespace detail
+
+/**
+ *  @brief Gets the identifier of a type.
+ *
+ *  @tparam T The type.
+ *  @return The identifier of the type.
+ */
+template <typename T> constexpr type_id type_of() {
+  return &detail::type_tag<T>::id;
+}
+
+/**
+ *  @brief Type-erased reference to a property.
+ *  @details This handle refers to a `property<T, copy>` of any type, without
+ * owning it and without allocating: it is a pointer to the property and a
+ * pointer to a static table of operations shared by all properties of the
+ * same type. Values are exchanged as bytes using `serializer<T>`. The
+ * property must outlive the handle.
+ */
+struct any_property {
+public:
+  /**
+   *  @brief Table of type-specific operations.
+   */
+  struct vtable {
+    /** @brief Appends the serialized value to a buffer. */
+    void (*get)(const void *prop, std::string &out);
+    /** @brief Sets the value from serialized bytes. */
+    bool (*set)(void *prop, std::string_view in);
+    /** @brief Adds a callback to the event. */
+    void (*subscribe)(void *prop, std::function<void()> callback);
+    /** @brief The identifier of the value type. */
+    type_id value_type;
+    /** @brief The copy state of the property. */
+    bool copy;
+  };
+
+  /**
+   *  @brief Creates a handle to a property.
+   *
+   *  @tparam T The type of the value.
+   *  @tparam copy The copy state of the property.
+   *  @param prop The property.
+   */
+  template <typename T, bool copy>
+  any_property(property<T, copy> &prop)
+      : object{&prop}, table{&table_for<T, copy>} {}
+
+  /**
+   *  @brief Appends the serialized value to a buffer.
+   *
+   *  @param out The buffer to append to.
+   */
+  void get_bytes(std::string &out) const { table->get(object, out); }
+  /**
+   *  @brief Gets the serialized value.
+   *  @return The bytes of the value.
+   */
+  std::string get_bytes() const {
+    std::string out;
+    get_bytes(out);
+    return out;
+  }
+  /**
+   *  @brief Sets the value from serialized bytes, then triggers the event.
+   *  @details Nothing happens if the bytes don't hold exactly one value.
+   *
+   *  @param in The bytes of the new value.
+   *  @return True if the value was set, otherwise false.
+   */
+  bool set_bytes(std::string_view in) const { return table->set(object, in); }
+  /**
+   *  @brief Adds a callback to the event of the property.
+   *
+   *  @param callback The callback, called after each change.
+   */
+  void subscribe(std::function<void()> callback) const {
+    table->subscribe(object, std::move(callback));
+  }
+
+  /**
+   *  @brief Gets the identifier of the value type.
+   *  @return The type identifier.
+   */
+  type_id type() const { return table->value_type; }
+  /**
+   *  @brief Checks the value type.
+   *
+   *  @tparam T The type to check.
+   *  @return True if the property holds a value of that type.
+   */
+  template <typename T> bool holds() const { return type() == type_of<T>(); }
+  /**
+   *  @brief Recovers the typed property.
+   *
+   *  @tparam T The type of the value.
+   *  @tparam copy The copy state of the property.
+   *  @return A pointer to the property, or `nullptr` if the type doesn't
+   * match.
+   */
+  template <typename T, bool copy = false> property<T, copy> *as() const {
+    if (table != &table_for<T, copy>)
+      return nullptr;
+    return static_cast<property<T, copy> *>(object);
+  }
+
+  /**
+   *  @brief Compares two handles.
+   *  @return True if both handles refer to the same property.
+   */
+  bool operator==(const any_property &other) const {
+    return object == other.object;
+  }
+  /**
+   *  @brief Compares two handles.
+   *  @return True if the handles refer to different properties.
+   */
+  bool operator!=(const any_property &other) const {
+    return object != other.object;
+  }
+
+private:
+  template <typename T, bool copy> struct ops {
+    using prop_type = property<T, copy>;
+
+    static void get(const void *prop, std::string &out) {
+      serializer<T>::write(out, static_cast<const prop_type *>(prop)->get());
+    }
+    static bool set(void *prop, std::string_view in) {
+      T value;
+      if (!deserialize(in, value))
+        return false;
+      static_cast<prop_type *>(prop)->set(value);
+      return true;
+    }
+    static void subscribe(void *prop, std::function<void()> callback) {
+      *static_cast<prop_type *>(prop) +
+          [callback = std::move(callback)](T &) { callback(); };
+    }
+  };
+
+  template <typename T, bool copy>
+  static constexpr vtable table_for = {
+      &ops<T, copy>::get, &ops<T, copy>::set, &ops<T, copy>::subscribe,
+      type_of<T>(), copy};
+
+  void *object;
+  const vtable *table;
+};
+} // namespace properties
+
+#endif /* _PROP_ANY_PROPERTY */
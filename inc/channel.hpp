@@ -0,0 +1,130 @@
+#ifndef _PROP_CHANNEL
+#define _PROP_CHANNEL
+
+#include "event.hpp"
+#include "property.hpp"
+
+#include <atomic>
+#include <utility>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ *  @brief Latest-value channel between one producer and one consumer thread.
+ *  @details The channel only keeps the most recent value: a publish
+ * overwrites whatever the consumer hasn't taken yet. It is a triple buffer,
+ * so both publishing and taking are a single atomic exchange (wait-free), and
+ * no memory is allocated after construction (apart from what copying `T`
+ * itself allocates).
+ *
+ * A channel can be attached to a property, in which case every change of the
+ * property is published. The channel event is triggered on the producer
+ * thread after each publish, which can be used to wake up the consumer.
+ *
+ *  @tparam T The type of the values.
+ */
+template <typename T> struct conflating_channel {
+public:
+  /**
+   *  @brief Creates a new channel.
+   *
+   *  @param initial The value `latest()` returns before the first take.
+   */
+  explicit conflating_channel(const T &initial = T{})
+      : buffers{{initial}, {initial}, {initial}} {}
+
+  /**
+   *  @brief Creates a new channel publishing every change of a property.
+   *  @details The property should only be written on the producer thread.
+   *
+   *  @tparam copy The copy state of the property.
+   *  @param source The property to publish.
+   */
+  template <bool copy>
+  explicit conflating_channel(property<T, copy> &source)
+      : conflating_channel(source.get()) {
+    source + [this](T &value) { publish(value); };
+  }
+
+  /**
+   *  @brief You can't copy a channel.
+   */
+  conflating_channel(const conflating_channel &) = delete;
+
+  /**
+   *  @brief Publishes a value (producer only), then triggers the event.
+   *
+   *  @param value The new value.
+   */
+  void publish(const T &value) {
+    buffers[back].value = value;
+    back = middle.exchange(back | fresh, std::memory_order_acq_rel) & index;
+    _ready.trigger(*this);
+  }
+
+  /**
+   *  @brief Takes the latest value, if any (consumer only).
+   *  @details On success, `latest()` returns the taken value.
+   *
+   *  @return True if a value was published since the last take.
+   */
+  bool take() {
+    if (!(middle.load(std::memory_order_relaxed) & fresh))
+      return false;
+    front = middle.exchange(front, std::memory_order_acq_rel) & index;
+    return true;
+  }
+  /**
+   *  @brief Takes the latest value, if any (consumer only).
+   *
+   *  @param out Receives the value, but only if there was one.
+   *  @return True if a value was published since the last take.
+   */
+  bool take(T &out) {
+    if (!take())
+      return false;
+    out = buffers[front].value;
+    return true;
+  }
+
+  /**
+   *  @brief Gets the last taken value (consumer only).
+   *  @return A constant reference to the value.
+   */
+  const T &latest() const { return buffers[front].value; }
+
+  /**
+   *  @brief Adds a callback to the event.
+   *  @details The callback is passed through to the event's `operator +`. It
+   * will be called on the producer thread after each publish.
+   *
+   * @param callback The callback to add to the event.
+   */
+  void operator+(typename event<conflating_channel &>::Callable callback) {
+    _ready + callback;
+  }
+
+  /**
+   *  @brief Destroys the channel.
+   */
+  ~conflating_channel() = default;
+
+private:
+  static constexpr unsigned index = 3;
+  static constexpr unsigned fresh = 4;
+
+  struct alignas(64) buffer {
+    T value;
+  };
+
+  buffer buffers[3];
+  alignas(64) std::atomic<unsigned> middle{1};
+  alignas(64) unsigned back = 0;
+  alignas(64) unsigned front = 2;
+  event<conflating_channel &> _ready;
+};
+} // namespace properties
+
+#endif /* _PROP_CHANNEL */
@@ -0,0 +1,383 @@
+#ifndef _PROP_DEPENDENCY_GRAPH
+#define _PROP_DEPENDENCY_GRAPH
+
+#include "event.hpp"
+#include "monitor.hpp"
+#include "thread_index.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ *  @brief Measured dependency graph of properties, computed nodes and events.
+ *  @details Tracking a node (anything with `attach_tracer`: events,
+ * properties, `computed`, `memoized` and `derived` values) adds it to the
+ * graph under a name. Edges aren't declared: when a tracked node triggers
+ * while a listener of another tracked node runs on the same thread, the
+ * graph records an edge between them, with the amount of times it was taken
+ * and the time spent below it. Untracked nodes in between are skipped, so the
+ * edge connects the nearest tracked ancestor. Edges only show up once they
+ * are taken.
+ *
+ * A top-level trigger and everything it causes is a propagation wave. The
+ * graph keeps the full trace of the most expensive wave, and its critical
+ * path: from the first node, each step follows the child that took the
+ * longest.
+ *
+ * Every trigger of a tracked node takes a lock, so this is meant for
+ * diagnosis rather than for production hot paths. The graph must outlive the
+ * tracked nodes.
+ */
+struct dependency_graph : trigger_tracer {
+public:
+  /**
+   *  @brief Measurements of a node.
+   */
+  struct node_stats {
+    /** @brief The name of the node. */
+    std::string name;
+    /** @brief The amount of triggers. */
+    std::uint64_t triggers;
+    /** @brief The time spent in those triggers, in ns. */
+    double total_ns;
+    /** @brief The time spent in them, minus the time of tracked children. */
+    double self_ns;
+  };
+
+  /**
+   *  @brief Measurements of an edge.
+   */
+  struct edge_stats {
+    /** @brief The index of the source node. */
+    std::uint32_t from;
+    /** @brief The index of the target node. */
+    std::uint32_t to;
+    /** @brief The amount of times the edge was taken. */
+    std::uint64_t calls;
+    /** @brief The time spent in the target's triggers, in ns. */
+    double total_ns;
+  };
+
+  /**
+   *  @brief A step of the critical path.
+   */
+  struct step {
+    /** @brief The index of the node. */
+    std::uint32_t node;
+    /** @brief The time taken by the trigger, in ns. */
+    double total_ns;
+    /** @brief The time taken, minus the time of tracked children. */
+    double self_ns;
+  };
+
+  /**
+   *  @brief All measurements, taken at once.
+   */
+  struct snapshot {
+    /** @brief The nodes, by index. */
+    std::vector<node_stats> nodes;
+    /** @brief The edges that were taken, sorted by source and target. */
+    std::vector<edge_stats> edges;
+    /** @brief The duration of the most expensive wave, in ns. */
+    double wave_ns;
+    /** @brief The critical path of that wave. */
+    std::vector<step> critical_path;
+  };
+
+  /**
+   *  @brief Creates an empty graph.
+   */
+  dependency_graph() = default;
+  /**
+   *  @brief You can't copy a graph.
+   */
+  dependency_graph(const dependency_graph &) = delete;
+
+  /**
+   *  @brief Starts tracing a node.
+   *
+   *  @tparam Node The type of the node.
+   *  @param name The name of the node.
+   *  @param target The node.
+   *  @return The index of the node.
+   */
+  template <typename Node>
+  std::uint32_t track(const std::string &name, Node &target) {
+    std::uint32_t index;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      index = static_cast<std::uint32_t>(nodes.size());
+      nodes.push_back({name, 0, 0, 0});
+    }
+    target.attach_tracer(this, index);
+    return index;
+  }
+
+  /**
+   *  @brief Collects all measurements.
+   *  @return The measurements.
+   */
+  snapshot collect() const {
+    double ratio = detail::cycle_clock::ns_per_tick();
+    snapshot result;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &n : nodes)
+      result.nodes.push_back({n.name, n.triggers, n.ticks * ratio,
+                              n.self_ticks * ratio});
+    for (const auto &[key, e] : edges)
+      result.edges.push_back({key.first, key.second, e.calls, e.ticks * ratio});
+    result.wave_ns = worst_ticks * ratio;
+    for (std::size_t i : critical_path()) {
+      const frame &f = worst[i];
+      result.critical_path.push_back(
+          {f.node, f.ticks * ratio, self_ticks(f) * ratio});
+    }
+    return result;
+  }
+
+  /**
+   *  @brief Renders the graph in the Graphviz DOT language.
+   *  @details Nodes are labeled with their triggers and total time, edges with
+   * their calls and time; heavier edges are drawn thicker, and the critical
+   * path is drawn in red.
+   *
+   *  @return The DOT text.
+   */
+  std::string dot() const {
+    snapshot s = collect();
+    double heaviest = 0;
+    for (const auto &e : s.edges)
+      heaviest = std::max(heaviest, e.total_ns);
+
+    std::string out = "digraph dependencies {\n  node [shape=box];\n";
+    for (std::size_t i = 0; i < s.nodes.size(); i++) {
+      const node_stats &n = s.nodes[i];
+      out += "  n" + std::to_string(i) + " [label=\"" + dot_escape(n.name) +
+             "\\n" + std::to_string(n.triggers) + " triggers, " +
+             number(n.total_ns / 1e3) + " us\"];\n";
+    }
+    for (const auto &e : s.edges) {
+      bool critical = false;
+      for (std::size_t i = 1; i < s.critical_path.size(); i++)
+        critical |= s.critical_path[i - 1].node == e.from &&
+                    s.critical_path[i].node == e.to;
+      double width = heaviest > 0 ? 1 + 4 * e.total_ns / heaviest : 1;
+      out += "  n" + std::to_string(e.from) + " -> n" + std::to_string(e.to) +
+             " [label=\"" + std::to_string(e.calls) + " calls, " +
+             number(e.total_ns / 1e3) + " us\", penwidth=" + number(width) +
+             (critical ? ", color=red" : "") + "];\n";
+    }
+    out += "}\n";
+    return out;
+  }
+
+  /**
+   *  @brief Renders the measurements as JSON.
+   *  @details The object has a `nodes` array (`id`, `name`, `triggers`,
+   * `total_ns`, `self_ns`), an `edges` array (`from`, `to`, `calls`,
+   * `total_ns`) and a `critical_path` object (`total_ns` and `steps`, each
+   * with `node`, `total_ns` and `self_ns`).
+   *
+   *  @return The JSON text.
+   */
+  std::string json() const {
+    snapshot s = collect();
+    std::string out = "{\"nodes\":[";
+    for (std::size_t i = 0; i < s.nodes.size(); i++) {
+      const node_stats &n = s.nodes[i];
+      out += std::string(i ? "," : "") + "{\"id\":" + std::to_string(i) +
+             ",\"name\":\"" + json_escape(n.name) + "\",\"triggers\":" +
+             std::to_string(n.triggers) + ",\"total_ns\":" +
+             number(n.total_ns) + ",\"self_ns\":" + number(n.self_ns) + "}";
+    }
+    out += "],\"edges\":[";
+    for (std::size_t i = 0; i < s.edges.size(); i++) {
+      const edge_stats &e = s.edges[i];
+      out += std::string(i ? "," : "") + "{\"from\":" +
+             std::to_string(e.from) + ",\"to\":" + std::to_string(e.to) +
+             ",\"calls\":" + std::to_string(e.calls) +
+             ",\"total_ns\":" + number(e.total_ns) + "}";
+    }
+    out += "],\"critical_path\":{\"total_ns\":" + number(s.wave_ns) +
+           ",\"steps\":[";
+    for (std::size_t i = 0; i < s.critical_path.size(); i++) {
+      const step &p = s.critical_path[i];
+      out += std::string(i ? "," : "") + "{\"node\":" +
+             std::to_string(p.node) + ",\"total_ns\":" + number(p.total_ns) +
+             ",\"self_ns\":" + number(p.self_ns) + "}";
+    }
+    out += "]}}\n";
+    return out;
+  }
+
+  /**
+   *  @brief Records the start of a trigger; called by tracked nodes.
+   *
+   *  @param node The index of the node.
+   */
+  void enter(std::uint32_t node) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    trace &t = traces[detail::thread_index()];
+    std::size_t parent = t.open.empty() ? root : t.open.back();
+    t.frames.push_back({node, parent, 0, 0});
+    t.open.push_back(t.frames.size() - 1);
+  }
+
+  /**
+   *  @brief Records the end of a trigger; called by tracked nodes.
+   *
+   *  @param node The index of the node.
+   *  @param ticks The duration of the trigger.
+   */
+  void leave(std::uint32_t node, std::uint64_t ticks) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    trace &t = traces[detail::thread_index()];
+    // the tracer may have been attached while the trigger was running
+    if (t.open.empty() || t.frames[t.open.back()].node != node)
+      return;
+    frame &f = t.frames[t.open.back()];
+    t.open.pop_back();
+    f.ticks = ticks;
+
+    node_entry &n = nodes[node];
+    n.triggers++;
+    n.ticks += ticks;
+    n.self_ticks += self_ticks(f);
+    if (f.parent != root) {
+      frame &parent = t.frames[f.parent];
+      parent.child_ticks += ticks;
+      edge_entry &e = edges[{parent.node, node}];
+      e.calls++;
+      e.ticks += ticks;
+      return;
+    }
+    if (ticks >= worst_ticks) {
+      worst_ticks = ticks;
+      worst.swap(t.frames);
+    }
+    t.frames.clear();
+  }
+
+  /**
+   *  @brief Destroys the graph.
+   */
+  ~dependency_graph() override = default;
+
+private:
+  static constexpr std::size_t root = std::numeric_limits<std::size_t>::max();
+
+  struct node_entry {
+    std::string name;
+    std::uint64_t triggers;
+    std::uint64_t ticks;
+    std::uint64_t self_ticks;
+  };
+
+  struct edge_entry {
+    std::uint64_t calls = 0;
+    std::uint64_t ticks = 0;
+  };
+
+  struct frame {
+    std::uint32_t node;
+    std::size_t parent;
+    std::uint64_t ticks;
+    std::uint64_t child_ticks;
+  };
+
+  struct trace {
+    std::vector<frame> frames;
+    std::vector<std::size_t> open;
+  };
+
+  static std::uint64_t self_ticks(const frame &f) {
+    return f.ticks > f.child_ticks ? f.ticks - f.child_ticks : 0;
+  }
+
+  // frames of the worst wave on the critical path, from the first node on
+  std::vector<std::size_t> critical_path() const {
+    std::vector<std::size_t> path;
+    if (worst.empty())
+      return path;
+    std::vector<std::vector<std::size_t>> children(worst.size());
+    for (std::size_t i = 1; i < worst.size(); i++)
+      children[worst[i].parent].push_back(i);
+    for (std::size_t current = 0;;) {
+      path.push_back(current);
+      const auto &next = children[current];
+      if (next.empty())
+        return path;
+      current = *std::max_element(
+          next.begin(), next.end(), [this](std::size_t a, std::size_t b) {
+            return worst[a].ticks < worst[b].ticks;
+          });
+    }
+  }
+
+  // escapes a DOT string literal
+  static std::string dot_escape(const std::string &text) {
+    std::string out;
+    for (char c : text) {
+      if (c == '\\' || c == '"')
+        out += '\\';
+      if (c == '\n')
+        out += "\\n";
+      else
+        out += c;
+    }
+    return out;
+  }
+
+  // escapes a JSON string literal
+  static std::string json_escape(const std::string &text) {
+    std::string out;
+    for (char c : text) {
+      auto byte = static_cast<unsigned char>(c);
+      if (c == '\\' || c == '"') {
+        out += '\\';
+        out += c;
+      } else if (c == '\n') {
+        out += "\\n";
+      } else if (c == '\r') {
+        out += "\\r";
+      } else if (c == '\t') {
+        out += "\\t";
+      } else if (byte < 0x20) {
+        char buffer[8];
+        std::snprintf(buffer, sizeof(buffer), "\\u%04x", byte);
+        out += buffer;
+      } else {
+        out += c;
+      }
+    }
+    return out;
+  }
+
+  static std::string number(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    return buffer;
+  }
+
+  mutable std::mutex mutex;
+  std::vector<node_entry> nodes;
+  std::map<std::pair<std::uint32_t, std::uint32_t>, edge_entry> edges;
+  std::unordered_map<std::size_t, trace> traces;
+  std::vector<frame> worst;
+  std::uint64_t worst_ticks = 0;
+};
+} // namespace properties
+
+#endif /* _PROP_DEPENDENCY_GRAPH */
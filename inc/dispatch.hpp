@@ -0,0 +1,498 @@
+#ifndef _PROP_DISPATCH
+#define _PROP_DISPATCH
+
+#include "metrics.hpp"
+#include "monitor.hpp"
+#include "probes.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ *  @brief Keeps the compiler from inlining a function into its callers; used
+ * for the cold paths of the dispatch core.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define PROP_NOINLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define PROP_NOINLINE __declspec(noinline)
+#else
+#define PROP_NOINLINE
+#endif
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ *  @brief Receives the start and end of every trigger of the events it is
+ * attached to.
+ *  @details Calls nest: a trigger caused by a listener of a traced trigger
+ * enters and leaves within it, on the same thread. Implementations must be
+ * thread-safe if the events are triggered from several threads.
+ */
+struct trigger_tracer {
+public:
+  /**
+   *  @brief Called when a trigger starts.
+   *
+   *  @param node The identifier the tracer was attached with.
+   */
+  virtual void enter(std::uint32_t node) = 0;
+  /**
+   *  @brief Called when a trigger ends (also when a listener throws).
+   *
+   *  @param node The identifier the tracer was attached with.
+   *  @param ticks The duration of the trigger, in `detail::cycle_clock` ticks.
+   */
+  virtual void leave(std::uint32_t node, std::uint64_t ticks) = 0;
+
+  /**
+   *  @brief Destroys the tracer.
+   */
+  virtual ~trigger_tracer() = default;
+};
+
+/**
+ * @brief Implementation details; not part of the public interface.
+ */
+namespace detail {
+/**
+ *  @brief Tag for listeners that take the type-erased argument as is.
+ */
+struct raw_argument {};
+
+/**
+ *  @brief Type-erased listener: a copyable callable taking a `void *` to the
+ * argument.
+ *  @details The layout matches `std::function` (an invoker, a manager and 16
+ * bytes of inline storage); callables that don't fit, or can throw when
+ * moved, are stored on the heap.
+ */
+struct erased_listener {
+public:
+  /**
+   *  @brief Creates an empty listener.
+   */
+  erased_listener() = default;
+
+  /**
+   *  @brief Wraps a callable.
+   *
+   *  @tparam Out The argument type of the event; the callable is invoked with
+   * `static_cast<Out>` of the argument, just like `std::function<void(Out)>`
+   * would be (`raw_argument` passes the `void *` itself).
+   *  @tparam F The type of the callable.
+   *  @param f The callable.
+   *  @return The listener.
+   */
+  template <typename Out, typename F> static erased_listener of(F &&f) {
+    using type = typename std::decay<F>::type;
+    erased_listener result;
+    if constexpr (local<type>())
+      new (result.store.local) type(std::forward<F>(f));
+    else
+      result.store.heap = new type(std::forward<F>(f));
+    result.invoker = &call<Out, type>;
+    result.manager = &manage<type>;
+    return result;
+  }
+
+  /**
+   *  @brief Copies another listener.
+   *
+   *  @param other The other listener.
+   */
+  erased_listener(const erased_listener &other)
+      : invoker{other.invoker}, manager{other.manager} {
+    if (manager)
+      manager(op::copy, this, const_cast<erased_listener *>(&other));
+  }
+  /**
+   *  @brief Moves another listener; the other one is empty afterwards.
+   *
+   *  @param other The other listener.
+   */
+  erased_listener(erased_listener &&other) noexcept
+      : invoker{other.invoker}, manager{other.manager} {
+    if (manager)
+      manager(op::move, this, &other);
+    other.invoker = nullptr;
+    other.manager = nullptr;
+  }
+  /**
+   *  @brief Replaces this listener by (a copy of) another one.
+   *
+   *  @param other The other listener.
+   *  @return A reference to this listener.
+   */
+  erased_listener &operator=(erased_listener other) noexcept {
+    reset();
+    new (this) erased_listener(std::move(other));
+    return *this;
+  }
+
+  /**
+   *  @brief Calls the listener.
+   *
+   *  @param arg A pointer to the argument.
+   */
+  void operator()(void *arg) { invoker(*this, arg); }
+
+  /**
+   *  @brief Destroys the listener.
+   */
+  ~erased_listener() { reset(); }
+
+private:
+  enum class op { copy, move, destroy };
+  using invoke_fn = void (*)(erased_listener &, void *);
+  using manage_fn = void (*)(op, erased_listener *, erased_listener *);
+
+  template <typename F> static constexpr bool local() {
+    return sizeof(F) <= sizeof(storage::local) &&
+           alignof(F) <= alignof(storage) &&
+           std::is_nothrow_move_constructible<F>::value;
+  }
+
+  template <typename F> static F *target(erased_listener &self) {
+    if constexpr (local<F>())
+      return std::launder(reinterpret_cast<F *>(self.store.local));
+    else
+      return static_cast<F *>(self.store.heap);
+  }
+
+  template <typename Out, typename F>
+  static void call(erased_listener &self, void *arg) {
+    if constexpr (std::is_same<Out, raw_argument>::value)
+      (*target<F>(self))(arg);
+    else
+      (*target<F>(self))(static_cast<Out>(
+          *static_cast<typename std::remove_reference<Out>::type *>(arg)));
+  }
+
+  template <typename F>
+  static void manage(op what, erased_listener *self, erased_listener *other) {
+    switch (what) {
+    case op::copy:
+      if constexpr (local<F>())
+        new (self->store.local) F(*target<F>(*other));
+      else
+        self->store.heap = new F(*target<F>(*other));
+      break;
+    case op::move:
+      if constexpr (local<F>()) {
+        new (self->store.local) F(std::move(*target<F>(*other)));
+        target<F>(*other)->~F();
+      } else {
+        self->store.heap = other->store.heap;
+      }
+      break;
+    case op::destroy:
+      if constexpr (local<F>())
+        target<F>(*self)->~F();
+      else
+        delete target<F>(*self);
+      break;
+    }
+  }
+
+  void reset() {
+    if (manager)
+      manager(op::destroy, this, nullptr);
+    invoker = nullptr;
+    manager = nullptr;
+  }
+
+  union storage {
+    void *heap;
+    alignas(void *) unsigned char local[16];
+  };
+
+  invoke_fn invoker = nullptr;
+  manage_fn manager = nullptr;
+  storage store;
+};
+
+/**
+ *  @brief Copies event arguments for asynchronous listeners.
+ */
+struct value_copier {
+  /** @brief Copies the argument `arg` points to onto the heap. */
+  void *(*copy)(void *arg);
+  /** @brief Destroys a copy. */
+  void (*destroy)(void *copy);
+};
+
+/**
+ *  @brief Gets the copier for a value type.
+ *
+ *  @tparam V The value type.
+ *  @return The copier, or `nullptr` if the values can't be copied.
+ */
+template <typename V> const value_copier *copier_for() {
+  if constexpr (std::is_copy_constructible<V>::value) {
+    static constexpr value_copier copier{
+        [](void *arg) -> void * { return new V(*static_cast<V *>(arg)); },
+        [](void *copy) { delete static_cast<V *>(copy); }};
+    return &copier;
+  } else {
+    return nullptr;
+  }
+}
+
+/**
+ *  @brief Gets the type-erased pointer to an event argument.
+ *
+ *  @tparam V The type of the argument.
+ *  @param value The argument.
+ *  @return A pointer to it.
+ */
+template <typename V> void *erase_argument(V &value) {
+  return const_cast<void *>(static_cast<const void *>(std::addressof(value)));
+}
+
+/**
+ *  @brief The type-independent part of every event.
+ *  @details Listener storage, registration and iteration, monitoring,
+ * metrics, tracing and probes live here once, instead of once for each event
+ * type; `event<Out>` only adds the typed interface. The argument is passed
+ * around as a `void *`, and each listener casts it back to its own type.
+ * Everything but the listeners is kept behind a single pointer, so an event
+ * without instrumentation stays small and its trigger checks one branch.
+ */
+struct dispatch_core {
+public:
+  /**
+   *  @brief Creates a core without listeners.
+   */
+  dispatch_core() = default;
+  /**
+   *  @brief Copies the listeners (and the monitoring policy, but not the
+   * statistics, metrics or tracer) of another core.
+   *
+   *  @param other The other core.
+   */
+  dispatch_core(const dispatch_core &other)
+      : listeners{other.listeners}, extra{clone(other.extra)} {}
+  /**
+   *  @brief Moves the listeners out of another core.
+   */
+  dispatch_core(dispatch_core &&) = default;
+  /**
+   *  @brief Copies the listeners (and the monitoring policy, but not the
+   * statistics) of another core; the metrics and tracer are kept.
+   *
+   *  @param other The other core.
+   *  @return A reference to this core.
+   */
+  dispatch_core &operator=(const dispatch_core &other) {
+    listeners = other.listeners;
+    auto copy = clone(other.extra);
+    if (extra) {
+      if (!copy)
+        copy = std::make_unique<instruments>();
+      copy->metrics = extra->metrics;
+      copy->tracer = extra->tracer;
+      copy->node = extra->node;
+    }
+    extra = std::move(copy);
+    prune();
+    return *this;
+  }
+  /**
+   *  @brief Moves the listeners out of another core.
+   *  @return A reference to this core.
+   */
+  dispatch_core &operator=(dispatch_core &&) = default;
+
+  /**
+   *  @brief Calls every listener with the argument.
+   *
+   *  @param arg A pointer to the argument.
+   */
+  void trigger(void *arg) {
+    PROP_PROBE2(trigger_begin, this, listeners.size());
+    if (extra) {
+      trigger_instrumented(arg);
+    } else {
+      for (std::size_t i = 0; i < listeners.size(); i++) {
+        PROP_PROBE2(listener_begin, this, i);
+        listeners[i](arg);
+        PROP_PROBE2(listener_end, this, i);
+      }
+    }
+    PROP_PROBE2(trigger_end, this, listeners.size());
+  }
+
+  /**
+   *  @brief Registers a listener.
+   *
+   *  @param listener The listener.
+   */
+  PROP_NOINLINE void add(erased_listener &&listener) {
+    listeners.push_back(std::move(listener));
+    if (extra && extra->metrics)
+      extra->metrics->set_listeners(listeners.size());
+  }
+
+  /**
+   *  @brief Starts timing each listener.
+   *
+   *  @param policy The monitoring configuration.
+   *  @param values The copier for the arguments, or `nullptr` if they can't
+   * be copied (flagged listeners then stay synchronous).
+   */
+  void monitor_listeners(const listener_policy &policy,
+                         const value_copier *values) {
+    instruments &x = tools();
+    x.monitor = std::make_unique<listener_monitor>(policy);
+    x.copier = values;
+  }
+
+  /**
+   *  @brief Gets the statistics of the listeners.
+   *  @return The statistics, or nothing if the core isn't monitored.
+   */
+  std::vector<listener_stats> listener_statistics() const {
+    if (!extra || !extra->monitor)
+      return {};
+    return extra->monitor->stats();
+  }
+
+  /**
+   *  @brief Counts triggers, listener calls and dispatch latency.
+   *
+   *  @param target The metrics to count into, or `nullptr` to stop counting.
+   */
+  void attach_metrics(event_metrics *target) {
+    tools().metrics = target;
+    if (target)
+      target->set_listeners(listeners.size());
+    prune();
+  }
+
+  /**
+   *  @brief Reports every trigger to a tracer.
+   *
+   *  @param target The tracer, or `nullptr` to stop tracing.
+   *  @param node The identifier passed to the tracer.
+   */
+  void attach_tracer(trigger_tracer *target, std::uint32_t node) {
+    instruments &x = tools();
+    x.tracer = target;
+    x.node = node;
+    prune();
+  }
+
+  /**
+   *  @brief Gets the amount of listeners.
+   *  @return The amount of listeners.
+   */
+  std::size_t size() const { return listeners.size(); }
+
+  /**
+   *  @brief Destroys the core.
+   */
+  ~dispatch_core() = default;
+
+private:
+  struct instruments {
+    std::unique_ptr<listener_monitor> monitor;
+    const value_copier *copier = nullptr;
+    event_metrics *metrics = nullptr;
+    trigger_tracer *tracer = nullptr;
+    std::uint32_t node = 0;
+  };
+
+  // reports the end of a trigger to the tracer, even if a listener throws
+  struct trace_scope {
+    ~trace_scope() {
+      if (tracer)
+        tracer->leave(node, cycle_clock::now() - start);
+    }
+    trigger_tracer *tracer;
+    std::uint32_t node;
+    std::uint64_t start;
+  };
+
+  static std::unique_ptr<instruments>
+  clone(const std::unique_ptr<instruments> &other) {
+    if (!other || !other->monitor)
+      return nullptr;
+    auto copy = std::make_unique<instruments>();
+    copy->monitor = std::make_unique<listener_monitor>(other->monitor->policy);
+    copy->copier = other->copier;
+    return copy;
+  }
+
+  instruments &tools() {
+    if (!extra)
+      extra = std::make_unique<instruments>();
+    return *extra;
+  }
+
+  void prune() {
+    if (extra && !extra->monitor && !extra->metrics && !extra->tracer)
+      extra.reset();
+  }
+
+  PROP_NOINLINE void trigger_instrumented(void *arg) {
+    instruments &x = *extra;
+    bool timed = x.metrics || x.tracer;
+    if (x.tracer)
+      x.tracer->enter(x.node);
+    std::uint64_t start = timed ? cycle_clock::now() : 0;
+    trace_scope scope{x.tracer, x.node, start};
+    if (x.monitor) {
+      trigger_monitored(arg);
+    } else {
+      for (std::size_t i = 0; i < listeners.size(); i++) {
+        PROP_PROBE2(listener_begin, this, i);
+        listeners[i](arg);
+        PROP_PROBE2(listener_end, this, i);
+      }
+    }
+    // listeners may have changed the instruments
+    if (timed && extra && extra->metrics)
+      extra->metrics->record(listeners.size(), cycle_clock::now() - start);
+  }
+
+  void trigger_monitored(void *arg) {
+    extra->monitor->track(listeners.size());
+    for (std::size_t i = 0; i < listeners.size(); i++) {
+      PROP_PROBE2(listener_begin, this, i);
+      std::uint64_t start = cycle_clock::now();
+      listeners[i](arg);
+      bool slow = extra->monitor->finish(i, start);
+      PROP_PROBE2(listener_end, this, i);
+      if (slow && extra->copier)
+        demote(i);
+    }
+  }
+
+  PROP_NOINLINE void demote(std::size_t i) {
+    auto callback = std::make_shared<erased_listener>(std::move(listeners[i]));
+    listener_pool *pool = extra->monitor->policy.pool;
+    std::size_t key = reinterpret_cast<std::uintptr_t>(this) / 64 + i;
+    const value_copier *values = extra->copier;
+    listeners[i] = erased_listener::of<raw_argument>(
+        [callback, pool, key, values](void *arg) {
+          std::shared_ptr<void> copy(values->copy(arg), values->destroy);
+          pool->post(key, [callback, copy]() { (*callback)(copy.get()); });
+        });
+    extra->monitor->demote(i);
+  }
+
+  std::vector<erased_listener> listeners;
+  std::unique_ptr<instruments> extra;
+};
+} // namespace detail
+} // namespace properties
+
+#endif /* _PROP_DISPATCH */
@@ -1,6 +1,9 @@
 #ifndef _PROP_EVENT
 #define _PROP_EVENT
 
+#include "dispatch.hpp"
+
+#include <cstdint>
 #include <functional>
 #include <type_traits>
 #include <vector>
@@ -15,6 +18,10 @@ namespace properties {
  * event is triggered. The callbacks will be called in the order they were
  * registered (added). Callbacks are of the signature `void(Out)`.
  *
+ * The storage and dispatch are shared by all event types (see
+ * `detail::dispatch_core`); this type only adds the typed interface, so each
+ * new `Out` costs little more than the callbacks themselves.
+ *
  *  @tparam Out The type of value that will be passed to the callbacks.
  */
 template <typename Out> struct event {
@@ -23,39 +30,112 @@ public:
    *  @brief The callable type is an alias for `std::function<void(Out)>`.
    */
   using Callable = std::function<void(Out)>;
+
+  /**
+   *  @brief Creates an event without callbacks.
+   */
+  event() = default;
+  /**
+   *  @brief Copies the callbacks (and the monitoring policy, but not the
+   * statistics) of another event.
+   */
+  event(const event &) = default;
+  /**
+   *  @brief Moves the callbacks out of another event.
+   */
+  event(event &&) = default;
+  /**
+   *  @brief Copies the callbacks (and the monitoring policy, but not the
+   * statistics) of another event.
+   *  @return A reference to this event.
+   */
+  event &operator=(const event &) = default;
+  /**
+   *  @brief Moves the callbacks out of another event.
+   *  @return A reference to this event.
+   */
+  event &operator=(event &&) = default;
+
   /**
    *  @brief Triggers the event.
    *  @details Each of the callbacks will be called in the order they were
    * registered with the proved value as parameter. If the parameter is a
    * reference or pointer, the value it refers/points to can be changed by the
-   * callbacks.
+   * callbacks. With `PROP_ENABLE_USDT`, the trigger and each callback are
+   * surrounded by probes (see `probes.hpp`).
    *
    *  @param val The value to pass to the callbacks.
    */
-  void trigger(Out val) {
-    for (auto &listener : listeners) {
-      listener(val);
-    }
-  }
+  void trigger(Out val) { core.trigger(detail::erase_argument(val)); }
 
   /**
    *  @brief Registers a callback.
    *  @details The callback is moved to the storage of the event. Calling the
    * callback after this call is undefined behavior.
    *
-   *  @tparam Call The type of the callback. This type should be convertible to
-   * the `event<Out>::Callback` type.
+   *  @tparam Call The type of the callback. It should be copyable and
+   * callable with an `Out`.
    *  @param other The callback. It will be moved from.
    */
   template <typename Call,
             typename _ = typename std::enable_if<
-                std::is_convertible<Call, Callable>::value>::type>
+                std::is_invocable<Call &, Out>::value &&
+                std::is_copy_constructible<
+                    typename std::decay<Call>::type>::value>::type>
   void operator+(Call &other) {
-    listeners.emplace_back(std::move(other));
+    core.add(detail::erased_listener::of<Out>(std::move(other)));
+  }
+
+  /**
+   *  @brief Starts timing each callback.
+   *  @details Callbacks that take longer than the budget for `strikes`
+   * consecutive calls are flagged. If the policy has a pool, flagged
+   * callbacks are moved to it: from then on, each trigger copies the value
+   * and posts the callback with the copy, so changes the callback makes to
+   * the value are lost. Callbacks of events over non-copyable values are only
+   * flagged. The pool must outlive the event; destroying the event doesn't
+   * wait for posted callbacks.
+   *
+   *  @param policy The monitoring configuration.
+   */
+  void monitor_listeners(const listener_policy &policy) {
+    core.monitor_listeners(policy, detail::copier_for<value_type>());
+  }
+
+  /**
+   *  @brief Gets the statistics of the callbacks.
+   *  @return The statistics, in registration order, or nothing if the event
+   * isn't monitored.
+   */
+  std::vector<listener_stats> listener_statistics() const {
+    return core.listener_statistics();
+  }
+
+  /**
+   *  @brief Counts triggers, listener calls and dispatch latency.
+   *  @details The metrics aren't copied along with the event, and must
+   * outlive it.
+   *
+   *  @param target The metrics to count into, or `nullptr` to stop counting.
+   */
+  void attach_metrics(event_metrics *target) { core.attach_metrics(target); }
+
+  /**
+   *  @brief Reports the start and end of every trigger to a tracer.
+   *  @details The tracer isn't copied along with the event, and must outlive
+   * it.
+   *
+   *  @param target The tracer, or `nullptr` to stop tracing.
+   *  @param node The identifier passed to the tracer.
+   */
+  void attach_tracer(trigger_tracer *target, std::uint32_t node) {
+    core.attach_tracer(target, node);
   }
 
 private:
-  std::vector<Callable> listeners;
+  using value_type = typename std::decay<Out>::type;
+
+  detail::dispatch_core core;
 };
 } // namespace properties
 
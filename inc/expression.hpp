@@ -0,0 +1,372 @@
+#ifndef _PROP_EXPRESSION
+#define _PROP_EXPRESSION
+
+#include "event.hpp"
+#include "property.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+template <typename E> struct computed;
+
+/**
+ *  @brief Trait for types that can be leaves of an expression.
+ *  @details A source has a `get()` getter and an `operator +(callback)` to
+ * subscribe to changes. Specialize this trait to use other types as leaves.
+ *
+ *  @tparam T The type to check.
+ */
+template <typename T> struct is_source : std::false_type {};
+/**
+ *  @brief Properties are sources.
+ */
+template <typename T, bool copy>
+struct is_source<property<T, copy>> : std::true_type {};
+/**
+ *  @brief Computed values are sources.
+ */
+template <typename E> struct is_source<computed<E>> : std::true_type {};
+
+/**
+ *  @brief Trait for expression nodes.
+ *
+ *  @tparam T The type to check.
+ */
+template <typename T> struct is_expression : std::false_type {};
+
+/**
+ * @brief Implementation details; not part of the public interface.
+ */
+namespace detail {
+template <typename T> using bare = std::remove_cv_t<std::remove_reference_t<T>>;
+
+// Sources are only usable as (non-const) lvalues, since the expression keeps a
+// reference to them and needs to subscribe to them.
+template <typename T>
+constexpr bool is_node_v =
+    is_expression<bare<T>>::value ||
+    (is_source<bare<T>>::value && std::is_lvalue_reference<T>::value &&
+     !std::is_const<std::remove_reference_t<T>>::value);
+
+template <typename T>
+constexpr bool is_operand_v =
+    is_node_v<T> || std::is_arithmetic<bare<T>>::value;
+
+template <typename L, typename R>
+using enable_binary = std::enable_if_t<(is_node_v<L> || is_node_v<R>) &&
+                                       is_operand_v<L> && is_operand_v<R>>;
+
+template <typename F> struct subscriber {
+  F callback;
+  std::vector<const void *> seen;
+
+  // Subscribes once per source, even if it occurs multiple times.
+  template <typename S> void operator()(S &source) {
+    if (std::find(seen.begin(), seen.end(), &source) != seen.end())
+      return;
+    seen.push_back(&source);
+    source + callback;
+  }
+};
+} // namespace detail
+
+/**
+ *  @brief Expression leaf referring to a source.
+ *
+ *  @tparam S The type of the source.
+ */
+template <typename S> struct leaf {
+  /** @brief The source. */
+  S *source;
+
+  /**
+   *  @brief Gets the value of the source.
+   *  @return The value.
+   */
+  decltype(auto) eval() const { return std::as_const(*source).get(); }
+  /**
+   *  @brief Subscribes to the source.
+   *  @param sub The subscriber.
+   */
+  template <typename Sub> void subscribe(Sub &sub) const { sub(*source); }
+};
+
+/**
+ *  @brief Expression leaf holding a constant.
+ *
+ *  @tparam T The type of the constant.
+ */
+template <typename T> struct constant {
+  /** @brief The constant. */
+  T value;
+
+  /**
+   *  @brief Gets the constant.
+   *  @return The constant.
+   */
+  const T &eval() const { return value; }
+  /**
+   *  @brief Constants never change; does nothing.
+   */
+  template <typename Sub> void subscribe(Sub &) const {}
+};
+
+/**
+ *  @brief Unary expression node.
+ *
+ *  @tparam Op The type of the operation.
+ *  @tparam E The type of the operand.
+ */
+template <typename Op, typename E> struct unary_expression {
+  /** @brief The operand. */
+  E operand;
+
+  /**
+   *  @brief Evaluates the expression.
+   *  @return The result.
+   */
+  auto eval() const { return Op{}(operand.eval()); }
+  /**
+   *  @brief Evaluates the expression.
+   *  @return The result.
+   */
+  operator decltype(Op{}(std::declval<const E &>().eval()))() const {
+    return eval();
+  }
+  /**
+   *  @brief Subscribes to all leaves of the operand.
+   *  @param sub The subscriber.
+   */
+  template <typename Sub> void subscribe(Sub &sub) const {
+    operand.subscribe(sub);
+  }
+};
+
+/**
+ *  @brief Binary expression node.
+ *
+ *  @tparam Op The type of the operation.
+ *  @tparam L The type of the left operand.
+ *  @tparam R The type of the right operand.
+ */
+template <typename Op, typename L, typename R> struct binary_expression {
+  /** @brief The left operand. */
+  L left;
+  /** @brief The right operand. */
+  R right;
+
+  /**
+   *  @brief Evaluates the expression.
+   *  @return The result.
+   */
+  auto eval() const { return Op{}(left.eval(), right.eval()); }
+  /**
+   *  @brief Evaluates the expression.
+   *  @return The result.
+   */
+  operator decltype(Op{}(std::declval<const L &>().eval(),
+                         std::declval<const R &>().eval()))() const {
+    return eval();
+  }
+  /**
+   *  @brief Subscribes to all leaves of both operands.
+   *  @param sub The subscriber.
+   */
+  template <typename Sub> void subscribe(Sub &sub) const {
+    left.subscribe(sub);
+    right.subscribe(sub);
+  }
+};
+
+/** @brief Leaves are expressions. */
+template <typename S> struct is_expression<leaf<S>> : std::true_type {};
+/** @brief Constants are expressions. */
+template <typename T> struct is_expression<constant<T>> : std::true_type {};
+/** @brief Unary nodes are expressions. */
+template <typename Op, typename E>
+struct is_expression<unary_expression<Op, E>> : std::true_type {};
+/** @brief Binary nodes are expressions. */
+template <typename Op, typename L, typename R>
+struct is_expression<binary_expression<Op, L, R>> : std::true_type {};
+
+namespace detail {
+template <typename T> auto as_expression(T &&value) {
+  if constexpr (is_expression<bare<T>>::value)
+    return bare<T>(std::forward<T>(value));
+  else if constexpr (is_source<bare<T>>::value)
+    return leaf<bare<T>>{&value};
+  else
+    return constant<bare<T>>{value};
+}
+
+template <typename Op, typename L, typename R>
+auto make_binary(L &&left, R &&right) {
+  auto l = as_expression(std::forward<L>(left));
+  auto r = as_expression(std::forward<R>(right));
+  return binary_expression<Op, decltype(l), decltype(r)>{std::move(l),
+                                                         std::move(r)};
+}
+} // namespace detail
+
+/**
+ *  @brief Builds an addition expression.
+ *  @details At least one operand should be a property, computed value or
+ * expression; the other one can also be an arithmetic constant.
+ *  @return The expression.
+ */
+template <typename L, typename R, typename = detail::enable_binary<L, R>>
+auto operator+(L &&left, R &&right) {
+  return detail::make_binary<std::plus<>>(std::forward<L>(left),
+                                          std::forward<R>(right));
+}
+/**
+ *  @brief Builds a subtraction expression.
+ *  @return The expression.
+ */
+template <typename L, typename R, typename = detail::enable_binary<L, R>>
+auto operator-(L &&left, R &&right) {
+  return detail::make_binary<std::minus<>>(std::forward<L>(left),
+                                           std::forward<R>(right));
+}
+/**
+ *  @brief Builds a multiplication expression.
+ *  @return The expression.
+ */
+template <typename L, typename R, typename = detail::enable_binary<L, R>>
+auto operator*(L &&left, R &&right) {
+  return detail::make_binary<std::multiplies<>>(std::forward<L>(left),
+                                                std::forward<R>(right));
+}
+/**
+ *  @brief Builds a division expression.
+ *  @return The expression.
+ */
+template <typename L, typename R, typename = detail::enable_binary<L, R>>
+auto operator/(L &&left, R &&right) {
+  return detail::make_binary<std::divides<>>(std::forward<L>(left),
+                                             std::forward<R>(right));
+}
+/**
+ *  @brief Builds a modulo expression.
+ *  @return The expression.
+ */
+template <typename L, typename R, typename = detail::enable_binary<L, R>>
+auto operator%(L &&left, R &&right) {
+  return detail::make_binary<std::modulus<>>(std::forward<L>(left),
+                                             std::forward<R>(right));
+}
+/**
+ *  @brief Builds a negation expression.
+ *  @return The expression.
+ */
+template <typename E, typename = std::enable_if_t<detail::is_node_v<E>>>
+auto operator-(E &&operand) {
+  auto e = detail::as_expression(std::forward<E>(operand));
+  return unary_expression<std::negate<>, decltype(e)>{std::move(e)};
+}
+
+/**
+ *  @brief Computed value.
+ *  @details This type holds the result of an expression over properties, such
+ * as `computed total = price * qty + fee;`. It subscribes to every property
+ * (or computed value) in the expression once, and re-evaluates the whole
+ * expression as a single inlined function whenever one of them changes. After
+ * re-evaluation, the change event is triggered. Since the computed value
+ * subscribes to its sources, it can't be copied or moved, and it should not
+ * outlive its sources.
+ *
+ *  @tparam E The type of the expression.
+ */
+template <typename E> struct computed {
+public:
+  /**
+   *  @brief The type of the result.
+   */
+  using value_type = std::decay_t<decltype(std::declval<const E &>().eval())>;
+
+  /**
+   *  @brief Creates a new computed value and evaluates it.
+   *
+   *  @param expression The expression.
+   */
+  computed(E expression)
+      : expression{std::move(expression)}, value(this->expression.eval()) {
+    auto refresh = [this](auto &) { update(); };
+    detail::subscriber<decltype(refresh)> sub{refresh, {}};
+    this->expression.subscribe(sub);
+  }
+
+  /**
+   *  @brief You can't copy a computed value.
+   */
+  computed(const computed &) = delete;
+  /**
+   *  @brief You can't move a computed value.
+   */
+  computed(computed &&) = delete;
+
+  /**
+   *  @brief Gets the current result.
+   *  @return A constant reference to the result.
+   */
+  const value_type &get() const { return value; }
+  /**
+   *  @brief Gets the current result (by const ref).
+   *  @return A constant reference to the result.
+   */
+  operator const value_type &() const { return value; }
+
+  /**
+   *  @brief Adds a callback to the event.
+   *  @details The callback is passed through to the event's `operator +`.
+   * Whenever the result is re-evaluated, the callback will be called with a
+   * constant reference to the new result.
+   *
+   * @param callback The callback to add to the event.
+   */
+  void operator+(typename event<const value_type &>::Callable callback) {
+    _set + callback;
+  }
+
+  /**
+   *  @brief Traces the triggers of the event.
+   *  @details See `event::attach_tracer`.
+   *
+   *  @param target The tracer, or `nullptr` to stop tracing.
+   *  @param node The identifier passed to the tracer.
+   */
+  void attach_tracer(trigger_tracer *target, std::uint32_t node) {
+    _set.attach_tracer(target, node);
+  }
+
+  /**
+   *  @brief Destroys the computed value.
+   */
+  ~computed() = default;
+
+private:
+  void update() {
+    value = expression.eval();
+    _set.trigger(value);
+  }
+
+  E expression;
+  value_type value;
+  event<const value_type &> _set;
+};
+
+/**
+ *  @brief Deduces the expression type of a computed value.
+ */
+template <typename E> computed(E) -> computed<E>;
+} // namespace properties
+
+#endif /* _PROP_EXPRESSION */
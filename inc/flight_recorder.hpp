@@ -0,0 +1,603 @@
+#ifndef _PROP_FLIGHT_RECORDER
+#define _PROP_FLIGHT_RECORDER
+
+#include "property.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ *  @brief On-disk format of flight recorder files.
+ *  @details A file holds a header, a table of property names and one ring of
+ * records per thread. Values are stored in host byte order, so files should
+ * be decoded on the same kind of machine that wrote them.
+ */
+namespace flight {
+/** @brief The magic bytes at the start of every file. */
+constexpr char magic[8] = {'P', 'R', 'O', 'P', 'F', 'L', 'T', '1'};
+/** @brief The version of the format. */
+constexpr std::uint32_t version = 2;
+/** @brief The maximum size of a value. */
+constexpr std::size_t value_capacity = 24;
+
+/**
+ *  @brief How a recorded value should be printed.
+ */
+enum class kind : std::uint32_t {
+  raw = 0,
+  signed_integer = 1,
+  unsigned_integer = 2,
+  floating_point = 3,
+  boolean = 4
+};
+
+/**
+ *  @brief Header at the start of the file.
+ */
+struct alignas(64) file_header {
+  /** @brief The magic bytes; see `flight::magic`. */
+  char magic[8];
+  /** @brief The version of the format. */
+  std::uint32_t version;
+  /** @brief The maximum amount of threads (rings). */
+  std::uint32_t max_threads;
+  /** @brief The amount of records per ring (a power of two). */
+  std::uint32_t ring_size;
+  /** @brief The maximum amount of named properties. */
+  std::uint32_t max_names;
+  /** @brief The system clock time when the file was created, in ns. */
+  std::uint64_t origin_system;
+  /** @brief The steady clock time when the file was created, in ns. */
+  std::uint64_t origin_steady;
+  /** @brief The amount of rings ever claimed by threads. */
+  std::atomic<std::uint32_t> threads;
+  /** @brief The amount of names in use. */
+  std::atomic<std::uint32_t> names;
+  /** @brief The amount of records dropped because no ring was free. */
+  std::atomic<std::uint64_t> overflow;
+};
+
+/**
+ *  @brief Entry in the name table.
+ */
+struct name_entry {
+  /** @brief The name, null-terminated. */
+  char name[40];
+  /** @brief How the value should be printed. */
+  kind value_kind;
+  /** @brief The size of the value. */
+  std::uint32_t size;
+};
+
+/**
+ *  @brief Header of a per-thread ring.
+ */
+struct alignas(64) ring_header {
+  /** @brief The amount of records ever written to the ring. */
+  std::atomic<std::uint64_t> next;
+  /** @brief The index of the last thread to claim the ring (starting at 1). */
+  std::atomic<std::uint64_t> thread;
+};
+
+/**
+ *  @brief Record of a single change.
+ *  @details `seq` is written last; a record is complete if `seq` is one more
+ * than its position in the ring's history.
+ */
+struct record {
+  /** @brief The sequence number of the record, starting at 1 (0: empty). */
+  std::atomic<std::uint64_t> seq;
+  /** @brief The steady clock time of the change, in ns. */
+  std::uint64_t time;
+  /** @brief The index of the thread that wrote the record. */
+  std::uint64_t thread;
+  /** @brief The identifier of the property. */
+  std::uint32_t id;
+  /** @brief The size of the value. */
+  std::uint32_t size;
+  /** @brief The bytes of the value. */
+  unsigned char bytes[value_capacity];
+};
+
+/**
+ *  @brief Offsets of the parts of a file.
+ */
+struct layout {
+  /**
+   *  @brief Computes the layout of a file.
+   *
+   *  @param max_threads The maximum amount of threads.
+   *  @param ring_size The amount of records per ring.
+   *  @param max_names The maximum amount of named properties.
+   */
+  layout(std::uint32_t max_threads, std::uint32_t ring_size,
+         std::uint32_t max_names)
+      : names{sizeof(file_header)},
+        rings{round(names + max_names * sizeof(name_entry))},
+        ring_bytes{round(sizeof(ring_header) + ring_size * sizeof(record))},
+        total{rings + max_threads * ring_bytes} {}
+
+  /** @brief The offset of the name table. */
+  std::size_t names;
+  /** @brief The offset of the first ring. */
+  std::size_t rings;
+  /** @brief The size of a ring, including its header. */
+  std::size_t ring_bytes;
+  /** @brief The size of the file. */
+  std::size_t total;
+
+private:
+  static std::size_t round(std::size_t n) { return (n + 63) / 64 * 64; }
+};
+
+/**
+ *  @brief Gets how a value type should be printed.
+ *
+ *  @tparam T The type of the value.
+ *  @return The kind of the value.
+ */
+template <typename T> constexpr kind kind_of() {
+  if (std::is_same<T, bool>::value)
+    return kind::boolean;
+  if (std::is_floating_point<T>::value)
+    return kind::floating_point;
+  if (std::is_integral<T>::value || std::is_enum<T>::value)
+    return std::is_signed<T>::value ? kind::signed_integer
+                                    : kind::unsigned_integer;
+  return kind::raw;
+}
+
+/**
+ *  @brief Gets the current steady clock time.
+ *  @return The time, in ns.
+ */
+inline std::uint64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ *  @brief Gets a process-wide index for the calling thread.
+ *  @return The index, starting at 1; indices are never reused.
+ */
+inline std::uint64_t thread_index() {
+  static std::atomic<std::uint64_t> counter{0};
+  static thread_local std::uint64_t index = ++counter;
+  return index;
+}
+} // namespace flight
+
+/**
+ *  @brief Always-on recorder of property changes into a memory-mapped file.
+ *  @details Every thread writes to its own ring in the file, so recording is
+ * a handful of plain stores without any locking or system call. Because the
+ * file is a shared mapping, the records written before a crash survive it
+ * (the kernel writes them back); they don't survive a power loss unless
+ * `sync()` was called. Each ring keeps the most recent `ring_size` records of
+ * its thread. Use `read_flight_log` or the `propflight` tool to decode a
+ * file.
+ *
+ * Threads claim a ring on their first record and hand it back when they
+ * exit; the next thread to claim it continues where the previous one
+ * stopped, so rings only run out when more than `max_threads` threads record
+ * at the same time. Records of threads that find no free ring are counted as
+ * overflow. If the file can't be created, the recorder does nothing.
+ */
+struct flight_recorder {
+public:
+  /**
+   *  @brief Creates (or truncates) a recorder file and maps it.
+   *
+   *  @param path The path of the file.
+   *  @param max_threads The maximum amount of recording threads.
+   *  @param ring_size The amount of records kept per thread; it is rounded up
+   * to a power of two.
+   *  @param max_names The maximum amount of watched properties.
+   */
+  explicit flight_recorder(const std::string &path,
+                           std::uint32_t max_threads = 64,
+                           std::uint32_t ring_size = 4096,
+                           std::uint32_t max_names = 256)
+      : instance{next_instance()}, pool{std::make_shared<ring_pool>()} {
+    std::uint32_t size = 1;
+    while (size < ring_size)
+      size <<= 1;
+    flight::layout parts(max_threads, size, max_names);
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      return;
+    void *map = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(parts.total)) == 0)
+      map = ::mmap(nullptr, parts.total, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+      return;
+
+    base = static_cast<unsigned char *>(map);
+    length = parts.total;
+    rings = base + parts.rings;
+    ring_bytes = parts.ring_bytes;
+    mask = size - 1;
+
+    header = new (base) flight::file_header{};
+    std::memcpy(header->magic, flight::magic, sizeof(flight::magic));
+    header->version = flight::version;
+    header->max_threads = max_threads;
+    header->ring_size = size;
+    header->max_names = max_names;
+    header->origin_system =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    header->origin_steady = flight::now();
+    names = reinterpret_cast<flight::name_entry *>(base + parts.names);
+    for (std::uint32_t i = 0; i < max_threads; i++)
+      new (rings + i * ring_bytes) flight::ring_header{};
+  }
+
+  /**
+   *  @brief You can't copy a recorder.
+   */
+  flight_recorder(const flight_recorder &) = delete;
+
+  /**
+   *  @brief Checks if the file was mapped.
+   *  @return True if records are written to the file.
+   */
+  bool is_open() const { return header != nullptr; }
+
+  /**
+   *  @brief Records all changes of a property.
+   *
+   *  @tparam T The type of the value; it should be trivially copyable and at
+   * most `flight::value_capacity` bytes.
+   *  @tparam copy The copy state of the property.
+   *  @param prop The property to watch.
+   *  @param name The name of the property in the file.
+   *  @return The identifier of the property in the records.
+   */
+  template <typename T, bool copy>
+  std::uint32_t watch(property<T, copy> &prop, const std::string &name) {
+    std::uint32_t id = declare<T>(name);
+    prop + [this, id](T &value) { record(id, value); };
+    return id;
+  }
+
+  /**
+   *  @brief Adds a name to the name table, without watching a property.
+   *
+   *  @tparam T The type of the values recorded under the name.
+   *  @param name The name.
+   *  @return The identifier to pass to `record`.
+   */
+  template <typename T> std::uint32_t declare(const std::string &name) {
+    if (!header)
+      return 0;
+    std::uint32_t id = header->names.fetch_add(1, std::memory_order_relaxed);
+    if (id < header->max_names) {
+      flight::name_entry &entry = names[id];
+      std::size_t n = std::min(name.size(), sizeof(entry.name) - 1);
+      std::memcpy(entry.name, name.data(), n);
+      entry.name[n] = '\0';
+      entry.value_kind = flight::kind_of<T>();
+      entry.size = sizeof(T);
+    }
+    return id;
+  }
+
+  /**
+   *  @brief Records a change on the calling thread's ring.
+   *
+   *  @tparam T The type of the value.
+   *  @param id The identifier of the property.
+   *  @param value The new value.
+   */
+  template <typename T> void record(std::uint32_t id, const T &value) {
+    static_assert(std::is_trivially_copyable<T>::value &&
+                      sizeof(T) <= flight::value_capacity,
+                  "flight_recorder: T doesn't fit in a record");
+    flight::ring_header *ring = own_ring();
+    if (!ring)
+      return;
+
+    std::uint64_t n = ring->next.load(std::memory_order_relaxed);
+    flight::record &r = records(ring)[n & mask];
+    r.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    r.time = flight::now();
+    r.thread = flight::thread_index();
+    r.id = id;
+    r.size = sizeof(T);
+    std::memcpy(r.bytes, &value, sizeof(T));
+    r.seq.store(n + 1, std::memory_order_release);
+    ring->next.store(n + 1, std::memory_order_release);
+  }
+
+  /**
+   *  @brief Writes the file back to disk, without waiting for it.
+   */
+  void sync() const {
+    if (base)
+      ::msync(base, length, MS_ASYNC);
+  }
+
+  /**
+   *  @brief Unmaps the file; it keeps the records.
+   */
+  ~flight_recorder() {
+    if (base)
+      ::munmap(base, length);
+  }
+
+private:
+  static std::uint64_t next_instance() {
+    static std::atomic<std::uint64_t> counter{0};
+    return ++counter;
+  }
+
+  flight::record *records(flight::ring_header *ring) const {
+    return reinterpret_cast<flight::record *>(
+        reinterpret_cast<unsigned char *>(ring) + sizeof(flight::ring_header));
+  }
+
+  flight::ring_header *ring_at(std::uint32_t i) const {
+    return reinterpret_cast<flight::ring_header *>(rings + i * ring_bytes);
+  }
+
+  // rings that are free to claim; shared with the claiming threads, so they
+  // can hand their rings back on exit even if the recorder is gone
+  struct ring_pool {
+    std::mutex mutex;
+    std::vector<std::uint32_t> free;
+    std::uint32_t next = 0;
+    // bumped whenever a ring is handed back
+    std::atomic<std::uint64_t> releases{0};
+  };
+
+  // the rings the calling thread holds, handed back when it exits
+  struct held_rings {
+    struct claim {
+      std::uint64_t instance;
+      std::weak_ptr<ring_pool> pool;
+      std::uint32_t ring;
+    };
+
+    ~held_rings() {
+      for (auto &c : claims)
+        if (auto p = c.pool.lock()) {
+          std::lock_guard<std::mutex> lock(p->mutex);
+          p->free.push_back(c.ring);
+          p->releases.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    std::vector<claim> claims;
+  };
+
+  flight::ring_header *own_ring() {
+    struct cache {
+      std::uint64_t instance = 0;
+      flight::ring_header *ring = nullptr;
+      std::uint64_t releases = 0;
+    };
+    static thread_local cache last;
+    if (last.instance == instance) {
+      if (last.ring)
+        return last.ring;
+      // no ring was free last time; only retry once one was handed back
+      if (last.releases == pool->releases.load(std::memory_order_acquire)) {
+        header->overflow.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+      }
+    }
+    if (!header)
+      return nullptr;
+
+    static thread_local held_rings held;
+    flight::ring_header *ring = nullptr;
+    for (const auto &c : held.claims)
+      if (c.instance == instance)
+        ring = ring_at(c.ring);
+    if (!ring) {
+      std::uint32_t i;
+      {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (!pool->free.empty()) {
+          i = pool->free.back();
+          pool->free.pop_back();
+        } else if (pool->next < header->max_threads) {
+          i = pool->next++;
+          header->threads.store(pool->next, std::memory_order_release);
+        } else {
+          header->overflow.fetch_add(1, std::memory_order_relaxed);
+          last = {instance, nullptr,
+                  pool->releases.load(std::memory_order_relaxed)};
+          return nullptr;
+        }
+      }
+      ring = ring_at(i);
+      ring->thread.store(flight::thread_index(), std::memory_order_relaxed);
+      auto &claims = held.claims;
+      claims.erase(std::remove_if(claims.begin(), claims.end(),
+                                  [](const held_rings::claim &c) {
+                                    return c.pool.expired();
+                                  }),
+                   claims.end());
+      claims.push_back({instance, pool, i});
+    }
+    last = {instance, ring};
+    return ring;
+  }
+
+  std::uint64_t instance;
+  std::shared_ptr<ring_pool> pool;
+  unsigned char *base = nullptr;
+  std::size_t length = 0;
+  flight::file_header *header = nullptr;
+  flight::name_entry *names = nullptr;
+  unsigned char *rings = nullptr;
+  std::size_t ring_bytes = 0;
+  std::uint64_t mask = 0;
+};
+
+/**
+ *  @brief A decoded flight recorder file.
+ */
+struct flight_log {
+  /**
+   *  @brief A watched property.
+   */
+  struct name {
+    /** @brief The name. */
+    std::string text;
+    /** @brief How the value should be printed. */
+    flight::kind value_kind;
+    /** @brief The size of the value. */
+    std::uint32_t size;
+  };
+
+  /**
+   *  @brief A decoded record.
+   */
+  struct entry {
+    /** @brief The time of the change, in ns since the file was created. */
+    std::uint64_t time;
+    /** @brief The index of the thread. */
+    std::uint64_t thread;
+    /** @brief The identifier of the property. */
+    std::uint32_t id;
+    /** @brief The size of the value. */
+    std::uint32_t size;
+    /** @brief The bytes of the value. */
+    unsigned char bytes[flight::value_capacity];
+  };
+
+  /** @brief The system clock time when the file was created, in ns. */
+  std::uint64_t origin;
+  /** @brief The amount of records dropped because no ring was free. */
+  std::uint64_t overflow;
+  /** @brief The names, indexed by property identifier. */
+  std::vector<name> names;
+  /** @brief The complete records of all threads, oldest first. */
+  std::vector<entry> entries;
+};
+
+/**
+ *  @brief Decodes a flight recorder file.
+ *  @details The file may still be written to: records that are incomplete,
+ * or that are overwritten while they are copied, are skipped.
+ *
+ *  @param path The path of the file.
+ *  @return The decoded file, or an empty optional if it isn't a valid file.
+ */
+inline std::optional<flight_log> read_flight_log(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return std::nullopt;
+  struct stat info;
+  void *map = MAP_FAILED;
+  if (::fstat(fd, &info) == 0 &&
+      static_cast<std::size_t>(info.st_size) >= sizeof(flight::file_header))
+    map = ::mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED)
+    return std::nullopt;
+
+  std::size_t size = info.st_size;
+  auto base = static_cast<const unsigned char *>(map);
+  auto header = reinterpret_cast<const flight::file_header *>(base);
+  std::optional<flight_log> result;
+  if (std::memcmp(header->magic, flight::magic, sizeof(flight::magic)) != 0 ||
+      header->version != flight::version || header->ring_size == 0 ||
+      (header->ring_size & (header->ring_size - 1)) != 0) {
+    ::munmap(map, size);
+    return result;
+  }
+  flight::layout parts(header->max_threads, header->ring_size,
+                       header->max_names);
+  if (parts.total > size) {
+    ::munmap(map, size);
+    return result;
+  }
+
+  flight_log log;
+  log.origin = header->origin_system;
+  log.overflow = header->overflow.load(std::memory_order_relaxed);
+  std::uint32_t name_count = std::min(
+      header->names.load(std::memory_order_acquire), header->max_names);
+  auto names =
+      reinterpret_cast<const flight::name_entry *>(base + parts.names);
+  for (std::uint32_t i = 0; i < name_count; i++)
+    log.names.push_back({std::string(names[i].name,
+                                     strnlen(names[i].name,
+                                             sizeof(names[i].name))),
+                         names[i].value_kind, names[i].size});
+
+  std::uint32_t threads = std::min(
+      header->threads.load(std::memory_order_acquire), header->max_threads);
+  std::uint64_t mask = header->ring_size - 1;
+  for (std::uint32_t t = 0; t < threads; t++) {
+    auto ring = reinterpret_cast<const flight::ring_header *>(
+        base + parts.rings + t * parts.ring_bytes);
+    auto records = reinterpret_cast<const flight::record *>(
+        reinterpret_cast<const unsigned char *>(ring) +
+        sizeof(flight::ring_header));
+    std::uint64_t next = ring->next.load(std::memory_order_acquire);
+    // the writer may have crashed between completing a record and bumping
+    // the ring's counter, so look one record further
+    std::uint64_t begin =
+        next > header->ring_size ? next - header->ring_size : 0;
+    for (std::uint64_t n = begin; n <= next; n++) {
+      const flight::record &r = records[n & mask];
+      if (r.seq.load(std::memory_order_acquire) != n + 1)
+        continue;
+      flight_log::entry e;
+      e.time = r.time;
+      e.thread = r.thread;
+      e.id = r.id;
+      e.size = r.size;
+      std::memcpy(e.bytes, r.bytes, sizeof(e.bytes));
+      // a writer that wrapped around onto the record while it was copied
+      // changed its sequence number, so the copy may be torn
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (r.seq.load(std::memory_order_relaxed) != n + 1 ||
+          e.size > flight::value_capacity)
+        continue;
+      e.time -= header->origin_steady;
+      log.entries.push_back(e);
+    }
+  }
+  std::stable_sort(log.entries.begin(), log.entries.end(),
+                   [](const flight_log::entry &a, const flight_log::entry &b) {
+                     return a.time < b.time;
+                   });
+  ::munmap(map, size);
+  result = std::move(log);
+  return result;
+}
+} // namespace properties
+
+#endif /* _PROP_FLIGHT_RECORDER */
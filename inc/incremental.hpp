@@ -0,0 +1,369 @@
+#ifndef _PROP_INCREMENTAL
+#define _PROP_INCREMENTAL
+
+#include "event.hpp"
+#include "serialize.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ *  @brief Fingerprints a sequence of bytes.
+ *  @details Uses the 64-bit FNV-1a hash. Fingerprints can be chained by
+ * passing the previous fingerprint as seed.
+ *
+ *  @param bytes The bytes to fingerprint.
+ *  @param seed The initial hash state.
+ *  @return The fingerprint of the bytes.
+ */
+inline std::uint64_t fingerprint(std::string_view bytes,
+                                 std::uint64_t seed = 0xcbf29ce484222325ULL) {
+  for (unsigned char c : bytes) {
+    seed ^= c;
+    seed *= 0x100000001b3ULL;
+  }
+  return seed;
+}
+
+/**
+ *  @brief On-disk content-addressed store.
+ *  @details The store keeps two kinds of files below its root directory:
+ * objects, which are blobs named by the fingerprint of their contents, and
+ * keys, which map an input fingerprint to the fingerprint of an object. Files
+ * are written to a temporary name unique to the writer, checked, and renamed
+ * into place, so neither a crash, a failed write nor concurrent writers of
+ * the same entry leave a partial entry behind. The store is a cache: failing
+ * to write an entry is not an error.
+ */
+struct content_store {
+public:
+  /**
+   *  @brief Opens (or creates) a store.
+   *
+   *  @param root The root directory of the store.
+   */
+  explicit content_store(std::filesystem::path root) : root{std::move(root)} {
+    std::error_code ec;
+    std::filesystem::create_directories(this->root / "objects", ec);
+    std::filesystem::create_directories(this->root / "keys", ec);
+  }
+
+  /**
+   *  @brief Stores a blob.
+   *  @details Storing the same contents twice only writes them once.
+   *
+   *  @param bytes The contents of the blob.
+   *  @return The fingerprint of the contents.
+   */
+  std::uint64_t put(std::string_view bytes) {
+    std::uint64_t hash = fingerprint(bytes);
+    auto path = object_path(hash);
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec))
+      write_file(path, bytes);
+    return hash;
+  }
+
+  /**
+   *  @brief Loads a blob.
+   *
+   *  @param hash The fingerprint of the contents.
+   *  @return The contents, or an empty optional if the blob is missing or
+   * corrupt.
+   */
+  std::optional<std::string> get(std::uint64_t hash) const {
+    auto bytes = read_file(object_path(hash));
+    if (!bytes || fingerprint(*bytes) != hash)
+      return std::nullopt;
+    return bytes;
+  }
+
+  /**
+   *  @brief Maps an input fingerprint to a blob.
+   *
+   *  @param key The input fingerprint.
+   *  @param hash The fingerprint of the blob.
+   */
+  void link(std::uint64_t key, std::uint64_t hash) {
+    write_file(key_path(key), serialize(hash));
+  }
+
+  /**
+   *  @brief Looks up the blob an input fingerprint maps to.
+   *
+   *  @param key The input fingerprint.
+   *  @return The fingerprint of the blob, or an empty optional if the key is
+   * unknown.
+   */
+  std::optional<std::uint64_t> lookup(std::uint64_t key) const {
+    auto bytes = read_file(key_path(key));
+    std::uint64_t hash;
+    if (!bytes || !deserialize(*bytes, hash))
+      return std::nullopt;
+    return hash;
+  }
+
+  /**
+   *  @brief Gets the root directory of the store.
+   *  @return The root directory.
+   */
+  const std::filesystem::path &path() const { return root; }
+
+private:
+  static std::string hex(std::uint64_t value) {
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx",
+                  static_cast<unsigned long long>(value));
+    return buffer;
+  }
+
+  std::filesystem::path object_path(std::uint64_t hash) const {
+    return root / "objects" / hex(hash);
+  }
+
+  std::filesystem::path key_path(std::uint64_t key) const {
+    return root / "keys" / hex(key);
+  }
+
+  static std::optional<std::string> read_file(const std::filesystem::path &p) {
+    std::ifstream in(p, std::ios::binary);
+    if (!in)
+      return std::nullopt;
+    return std::string(std::istreambuf_iterator<char>(in), {});
+  }
+
+  // unique per writer: a random per-process base, so processes sharing the
+  // store don't collide, plus a counter, so threads don't either
+  static std::string temp_suffix() {
+    static const std::uint64_t base = [] {
+      std::random_device random;
+      return (std::uint64_t{random()} << 32) ^ random();
+    }();
+    static std::atomic<std::uint64_t> counter{0};
+    return "." + hex(base) + "-" +
+           std::to_string(counter.fetch_add(1, std::memory_order_relaxed)) +
+           ".tmp";
+  }
+
+  static void write_file(const std::filesystem::path &p,
+                         std::string_view bytes) {
+    auto tmp = p;
+    tmp += temp_suffix();
+    std::error_code ec;
+    {
+      std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+      out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+      out.close();
+      if (out.fail()) {
+        std::filesystem::remove(tmp, ec);
+        return;
+      }
+    }
+    std::filesystem::rename(tmp, p, ec);
+    if (ec)
+      std::filesystem::remove(tmp, ec);
+  }
+
+  std::filesystem::path root;
+};
+
+/**
+ *  @brief Incrementally computed, persisted value.
+ *  @details This type holds the result of a pure function over one or more
+ * inputs, like `memoized<R, Args...>`, but caches results in a
+ * `content_store` that survives process restarts. The inputs are fingerprinted
+ * together with the name of the node; if the store already holds a result for
+ * that fingerprint, it is loaded instead of computed. This also happens when
+ * the node is created, so a restarted process only recomputes the nodes whose
+ * inputs changed.
+ *
+ * When the new result has the same fingerprint as the current one (early
+ * cutoff), the event is not triggered, so nodes depending on this one are not
+ * updated either.
+ *
+ * Inputs can be any object with a `get()` getter and an `operator +(callback)`
+ * to subscribe to changes, such as `property<T, copy>` or another
+ * `derived<R, Args...>`. The result and input types need a `serializer`.
+ *
+ *  @tparam R The type of the result.
+ *  @tparam Args The types of the input values.
+ */
+template <typename R, typename... Args> struct derived {
+public:
+  /**
+   *  @brief The function type is an alias for `std::function<R(const
+   * Args &...)>`.
+   */
+  using Function = std::function<R(const Args &...)>;
+
+  /**
+   *  @brief Creates a new node and loads or computes its initial result.
+   *  @details The name identifies the function in the store. Two nodes with a
+   * different function should never share the same name.
+   *
+   *  @tparam Sources The types of the inputs.
+   *  @param store The store to persist results in.
+   *  @param name The name of the node.
+   *  @param func The function computing the result.
+   *  @param sources The inputs of the function, in parameter order.
+   */
+  template <typename... Sources>
+  derived(content_store &store, std::string name, Function func,
+          Sources &...sources)
+      : store{store}, name{std::move(name)}, func{std::move(func)},
+        read{[&sources...]() { return key_type{sources.get()...}; }} {
+    static_assert(sizeof...(Sources) == sizeof...(Args),
+                  "derived: one input is required per function parameter");
+    ((sources + [this](auto &) { update(); }), ...);
+    update();
+  }
+
+  /**
+   *  @brief You can't copy a derived node.
+   */
+  derived(const derived &) = delete;
+  /**
+   *  @brief You can't move a derived node.
+   */
+  derived(derived &&) = delete;
+
+  /**
+   *  @brief Gets the current result.
+   *  @return A constant reference to the result.
+   */
+  const R &get() const { return *value; }
+  /**
+   *  @brief Gets the current result (by const ref).
+   *  @return A constant reference to the result.
+   */
+  operator const R &() const { return *value; }
+
+  /**
+   *  @brief Gets the amount of times the function was called.
+   *  @return The amount of computations.
+   */
+  std::size_t computed() const { return compute_count; }
+  /**
+   *  @brief Gets the amount of results loaded from the store.
+   *  @return The amount of loads.
+   */
+  std::size_t loaded() const { return load_count; }
+  /**
+   *  @brief Gets the amount of updates that didn't change the result.
+   *  @return The amount of early cutoffs.
+   */
+  std::size_t cutoffs() const { return cutoff_count; }
+
+  /**
+   *  @brief Adds a callback to the event.
+   *  @details The callback is passed through to the event's `operator +`.
+   * Whenever the result changes, the callback will be called with a constant
+   * reference to the new result.
+   *
+   * @param callback The callback to add to the event.
+   */
+  void operator+(typename event<const R &>::Callable callback) {
+    _set + callback;
+  }
+
+  /**
+   *  @brief Traces the triggers of the event.
+   *  @details See `event::attach_tracer`.
+   *
+   *  @param target The tracer, or `nullptr` to stop tracing.
+   *  @param node The identifier passed to the tracer.
+   */
+  void attach_tracer(trigger_tracer *target, std::uint32_t node) {
+    _set.attach_tracer(target, node);
+  }
+
+  /**
+   *  @brief Destroys the node.
+   */
+  ~derived() = default;
+
+private:
+  using key_type = std::tuple<Args...>;
+
+  std::uint64_t input_fingerprint(const key_type &inputs) const {
+    std::string bytes;
+    serializer<std::string>::write(bytes, name);
+    std::apply(
+        [&bytes](const Args &...args) {
+          (serializer<Args>::write(bytes, args), ...);
+        },
+        inputs);
+    return fingerprint(bytes);
+  }
+
+  std::optional<R> load(std::uint64_t key, std::uint64_t &hash) const {
+    auto linked = store.lookup(key);
+    if (!linked)
+      return std::nullopt;
+    auto bytes = store.get(*linked);
+    R result;
+    if (!bytes || !deserialize(*bytes, result))
+      return std::nullopt;
+    hash = *linked;
+    return result;
+  }
+
+  void update() {
+    key_type inputs = read();
+    std::uint64_t key = input_fingerprint(inputs);
+    if (value && key == input_key)
+      return;
+    input_key = key;
+
+    std::uint64_t hash = 0;
+    std::optional<R> result = load(key, hash);
+    if (result) {
+      load_count++;
+    } else {
+      result = std::apply(func, inputs);
+      compute_count++;
+      hash = store.put(serialize(*result));
+      store.link(key, hash);
+    }
+
+    if (value && hash == output_hash) {
+      cutoff_count++;
+      return;
+    }
+    bool initial = !value;
+    value = std::move(result);
+    output_hash = hash;
+    if (!initial)
+      _set.trigger(*value);
+  }
+
+  content_store &store;
+  std::string name;
+  Function func;
+  std::function<key_type()> read;
+  std::optional<R> value;
+  std::uint64_t input_key = 0;
+  std::uint64_t output_hash = 0;
+  std::size_t compute_count = 0;
+  std::size_t load_count = 0;
+  std::size_t cutoff_count = 0;
+  event<const R &> _set;
+};
+} // namespace properties
+
+#endif /* _PROP_INCREMENTAL */
@@ -0,0 +1,283 @@
+#ifndef _PROP_MEMOIZED
+#define _PROP_MEMOIZED
+
+#include "event.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ *  @brief Hash functor for tuples.
+ *  @details Combines the `std::hash` of each element of the tuple into a
+ * single hash value.
+ *
+ *  @tparam Args The types of the tuple elements.
+ */
+template <typename... Args> struct tuple_hash {
+  /**
+   *  @brief Hashes a tuple.
+   *
+   *  @param tuple The tuple to hash.
+   *  @return The combined hash of all elements.
+   */
+  std::size_t operator()(const std::tuple<Args...> &tuple) const {
+    return std::apply(
+        [](const Args &...args) {
+          std::size_t seed = 0;
+          ((seed ^= std::hash<Args>{}(args) + 0x9e3779b97f4a7c15ULL +
+                    (seed << 6) + (seed >> 2)),
+           ...);
+          return seed;
+        },
+        tuple);
+  }
+};
+
+/**
+ *  @brief Bounded least-recently-used cache.
+ *  @details Holds at most `capacity()` entries. Looking up or inserting an
+ * entry makes it the most recently used one; inserting into a full cache
+ * evicts the least recently used entry. References to cached values stay valid
+ * until their entry is evicted.
+ *
+ *  @tparam K The key type.
+ *  @tparam V The value type.
+ *  @tparam Hash The hash functor for the keys.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>>
+struct lru_cache {
+public:
+  /**
+   *  @brief Creates an empty cache.
+   *
+   *  @param capacity The maximum number of entries (at least 1).
+   */
+  explicit lru_cache(std::size_t capacity)
+      : max{capacity == 0 ? 1 : capacity} {}
+
+  /**
+   *  @brief Looks up a key and marks it as most recently used.
+   *
+   *  @param key The key to look up.
+   *  @return A pointer to the cached value, or `nullptr` on a miss.
+   */
+  V *find(const K &key) {
+    auto it = index.find(key);
+    if (it == index.end())
+      return nullptr;
+    entries.splice(entries.begin(), entries, it->second);
+    return &it->second->second;
+  }
+
+  /**
+   *  @brief Inserts (or overwrites) an entry as the most recently used one.
+   *  @details If the cache is full, the least recently used entry is evicted
+   * first.
+   *
+   *  @param key The key of the entry.
+   *  @param value The value of the entry. It will be moved from.
+   *  @return A reference to the cached value.
+   */
+  V &insert(const K &key, V value) {
+    if (V *existing = find(key)) {
+      *existing = std::move(value);
+      return *existing;
+    }
+    if (entries.size() == max) {
+      index.erase(entries.back().first);
+      entries.pop_back();
+    }
+    entries.emplace_front(key, std::move(value));
+    index.emplace(key, entries.begin());
+    return entries.front().second;
+  }
+
+  /**
+   *  @brief Removes all entries from the cache.
+   */
+  void clear() {
+    index.clear();
+    entries.clear();
+  }
+
+  /**
+   *  @brief Gets the amount of entries in the cache.
+   *  @return The amount of entries.
+   */
+  std::size_t size() const { return entries.size(); }
+  /**
+   *  @brief Gets the maximum amount of entries in the cache.
+   *  @return The capacity.
+   */
+  std::size_t capacity() const { return max; }
+
+private:
+  using entry_list = std::list<std::pair<K, V>>;
+
+  std::size_t max;
+  entry_list entries;
+  std::unordered_map<K, typename entry_list::iterator, Hash> index;
+};
+
+/**
+ *  @brief Memoized computed value.
+ *  @details This type holds the result of a pure function over the values of
+ * one or more input properties. Whenever one of the inputs changes, the result
+ * is looked up in a bounded LRU cache keyed by the input values; the function
+ * is only called on a cache miss. Afterwards, the change event is triggered
+ * with the (possibly cached) result.
+ *
+ * Inputs can be any object with a `get()` getter and an `operator +(callback)`
+ * to subscribe to changes, such as `property<T, copy>` or another
+ * `memoized<R, Args...>`. Since the memoized value subscribes to its inputs,
+ * it can't be copied or moved, and it should not outlive its inputs.
+ *
+ *  @tparam R The type of the result.
+ *  @tparam Args The types of the input values.
+ */
+template <typename R, typename... Args> struct memoized {
+public:
+  /**
+   *  @brief The function type is an alias for `std::function<R(const
+   * Args &...)>`.
+   */
+  using Function = std::function<R(const Args &...)>;
+
+  /**
+   *  @brief Creates a new memoized value and computes its initial result.
+   *  @details The function should be pure: its result may only depend on its
+   * parameters.
+   *
+   *  @tparam Sources The types of the inputs.
+   *  @param capacity The maximum amount of cached results.
+   *  @param func The function computing the result.
+   *  @param sources The inputs of the function, in parameter order.
+   */
+  template <typename... Sources>
+  memoized(std::size_t capacity, Function func, Sources &...sources)
+      : func{std::move(func)},
+        read{[&sources...]() { return key_type{sources.get()...}; }},
+        cache{capacity} {
+    static_assert(sizeof...(Sources) == sizeof...(Args),
+                  "memoized: one input is required per function parameter");
+    ((sources + [this](auto &) { update(); }), ...);
+    current = &lookup();
+  }
+
+  /**
+   *  @brief You can't copy a memoized value.
+   */
+  memoized(const memoized &) = delete;
+  /**
+   *  @brief You can't move a memoized value.
+   */
+  memoized(memoized &&) = delete;
+
+  /**
+   *  @brief Gets the current result.
+   *  @return A constant reference to the result.
+   */
+  const R &get() const { return *current; }
+  /**
+   *  @brief Gets the current result (by const ref).
+   *  @return A constant reference to the result.
+   */
+  operator const R &() const { return *current; }
+
+  /**
+   *  @brief Recomputes the result, bypassing the cache.
+   *  @details All cached results are discarded, after which the result is
+   * computed again and the event is triggered.
+   */
+  void invalidate() {
+    cache.clear();
+    update();
+  }
+
+  /**
+   *  @brief Gets the amount of input changes answered from the cache.
+   *  @return The amount of cache hits.
+   */
+  std::size_t hits() const { return hit_count; }
+  /**
+   *  @brief Gets the amount of times the function was called.
+   *  @return The amount of cache misses.
+   */
+  std::size_t misses() const { return miss_count; }
+  /**
+   *  @brief Gets the amount of cached results.
+   *  @return The cache size.
+   */
+  std::size_t size() const { return cache.size(); }
+  /**
+   *  @brief Gets the maximum amount of cached results.
+   *  @return The cache capacity.
+   */
+  std::size_t capacity() const { return cache.capacity(); }
+
+  /**
+   *  @brief Adds a callback to the event.
+   *  @details The callback is passed through to the event's `operator +`.
+   * Whenever the result changes, the callback will be called with a constant
+   * reference to the new result.
+   *
+   * @param callback The callback to add to the event.
+   */
+  void operator+(typename event<const R &>::Callable callback) {
+    _set + callback;
+  }
+
+  /**
+   *  @brief Traces the triggers of the event.
+   *  @details See `event::attach_tracer`.
+   *
+   *  @param target The tracer, or `nullptr` to stop tracing.
+   *  @param node The identifier passed to the tracer.
+   */
+  void attach_tracer(trigger_tracer *target, std::uint32_t node) {
+    _set.attach_tracer(target, node);
+  }
+
+  /**
+   *  @brief Destroys the memoized value.
+   */
+  ~memoized() = default;
+
+private:
+  using key_type = std::tuple<Args...>;
+
+  R &lookup() {
+    key_type key = read();
+    if (R *cached = cache.find(key)) {
+      hit_count++;
+      return *cached;
+    }
+    miss_count++;
+    return cache.insert(key, std::apply(func, key));
+  }
+
+  void update() {
+    current = &lookup();
+    _set.trigger(*current);
+  }
+
+  Function func;
+  std::function<key_type()> read;
+  lru_cache<key_type, R, tuple_hash<Args...>> cache;
+  const R *current = nullptr;
+  std::size_t hit_count = 0;
+  std::size_t miss_count = 0;
+  event<const R &> _set;
+};
+} // namespace properties
+
+#endif /* _PROP_MEMOIZED */
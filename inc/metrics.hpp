@@ -0,0 +1,164 @@
+#ifndef _PROP_METRICS
+#define _PROP_METRICS
+
+#include "thread_index.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ *  @brief Counters of a single event, sharded per thread.
+ *  @details Each thread counts into its own cache-line aligned shard with
+ * plain (relaxed) loads and stores, so triggering threads never contend with
+ * each other or with `collect()`, which only reads. Shards are reused by later
+ * threads after their thread exits, so all counters stay monotonic. At most
+ * `max_threads` threads can count at the same time.
+ *
+ * Attach metrics to an event with `event::attach_metrics` (or through a
+ * `metrics_registry`, see `prometheus.hpp`).
+ */
+struct event_metrics {
+public:
+  /**
+   *  @brief The maximum amount of concurrently counting threads.
+   */
+  static constexpr std::size_t max_threads = 4096;
+  /**
+   *  @brief The amount of latency buckets; bucket `i` holds latencies of
+   * less than `2^i` ticks (and at least `2^(i-1)`).
+   */
+  static constexpr std::size_t buckets = 48;
+
+  /**
+   *  @brief Combined counters of all threads.
+   */
+  struct snapshot {
+    /** @brief The amount of triggers. */
+    std::uint64_t triggers = 0;
+    /** @brief The amount of listener calls (summed over all triggers). */
+    std::uint64_t listener_calls = 0;
+    /** @brief The total dispatch time, in ticks (see `ns_per_tick`). */
+    std::uint64_t latency = 0;
+    /** @brief The dispatch latency histogram, in ticks. */
+    std::uint64_t histogram[buckets] = {};
+    /** @brief The amount of listeners registered on the event. */
+    std::uint64_t listeners = 0;
+  };
+
+  /**
+   *  @brief Creates zeroed metrics.
+   */
+  event_metrics() = default;
+  /**
+   *  @brief You can't copy metrics.
+   */
+  event_metrics(const event_metrics &) = delete;
+
+  /**
+   *  @brief Counts a trigger on the calling thread.
+   *
+   *  @param listener_calls The amount of listeners called.
+   *  @param ticks The dispatch time, in ticks.
+   */
+  void record(std::size_t listener_calls, std::uint64_t ticks) {
+    shard &s = shard_for(detail::thread_index());
+    bump(s.triggers, 1);
+    bump(s.listener_calls, listener_calls);
+    bump(s.latency, ticks);
+    std::size_t bucket = 0;
+    while (bucket + 1 < buckets && (ticks >> bucket) != 0)
+      bucket++;
+    bump(s.histogram[bucket], 1);
+  }
+
+  /**
+   *  @brief Updates the listener count.
+   *
+   *  @param count The amount of listeners.
+   */
+  void set_listeners(std::size_t count) {
+    listeners.store(count, std::memory_order_relaxed);
+  }
+
+  /**
+   *  @brief Combines the counters of all threads.
+   *  @details Counts made by other threads concurrently may or may not be
+   * included.
+   *
+   *  @return The combined counters.
+   */
+  snapshot collect() const {
+    snapshot result;
+    result.listeners = listeners.load(std::memory_order_relaxed);
+    for (const auto &chunk : chunks) {
+      shard_chunk *c = chunk.load(std::memory_order_acquire);
+      if (c == nullptr)
+        continue;
+      for (const auto &s : c->shards) {
+        result.triggers += s.triggers.load(std::memory_order_relaxed);
+        result.listener_calls +=
+            s.listener_calls.load(std::memory_order_relaxed);
+        result.latency += s.latency.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < buckets; i++)
+          result.histogram[i] += s.histogram[i].load(std::memory_order_relaxed);
+      }
+    }
+    return result;
+  }
+
+  /**
+   *  @brief Destroys the metrics.
+   */
+  ~event_metrics() {
+    for (auto &chunk : chunks)
+      delete chunk.load();
+  }
+
+private:
+  static constexpr std::size_t chunk_size = 64;
+
+  struct alignas(64) shard {
+    std::atomic<std::uint64_t> triggers{0};
+    std::atomic<std::uint64_t> listener_calls{0};
+    std::atomic<std::uint64_t> latency{0};
+    std::atomic<std::uint64_t> histogram[buckets] = {};
+  };
+
+  struct shard_chunk {
+    shard shards[chunk_size];
+  };
+
+  static void bump(std::atomic<std::uint64_t> &counter, std::uint64_t by) {
+    counter.store(counter.load(std::memory_order_relaxed) + by,
+                  std::memory_order_relaxed);
+  }
+
+  shard &shard_for(std::size_t index) {
+    assert(index < max_threads);
+    auto &chunk = chunks[index / chunk_size];
+    shard_chunk *c = chunk.load(std::memory_order_acquire);
+    if (c == nullptr) {
+      std::lock_guard<std::mutex> lock(mutex);
+      c = chunk.load(std::memory_order_relaxed);
+      if (c == nullptr) {
+        c = new shard_chunk;
+        chunk.store(c, std::memory_order_release);
+      }
+    }
+    return c->shards[index % chunk_size];
+  }
+
+  std::mutex mutex;
+  std::atomic<std::uint64_t> listeners{0};
+  std::atomic<shard_chunk *> chunks[max_threads / chunk_size] = {};
+};
+} // namespace properties
+
+#endif /* _PROP_METRICS */
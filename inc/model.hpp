@@ -0,0 +1,34 @@
+#ifndef _PROP_MODEL
+#define _PROP_MODEL
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ *  @brief Bitmask of model fields; bit `i` stands for the field with index
+ * `i`.
+ */
+using change_mask = std::uint64_t;
+
+/**
+ *  @brief Compile-time description of a field of a generated model.
+ *  @details Models generated by `propgen` expose a `constexpr` table of these
+ * as `fields`, in declaration order.
+ */
+struct field_info {
+  /** @brief The name of the field. */
+  const char *name;
+  /** @brief The C++ type of the field, as spelled in the schema. */
+  const char *type;
+  /** @brief The index of the field, in declaration order. */
+  std::size_t index;
+  /** @brief The change mask bit of the field. */
+  change_mask mask;
+};
+} // namespace properties
+
+#endif /* _PROP_MODEL */
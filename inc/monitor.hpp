@@ -0,0 +1,302 @@
+#ifndef _PROP_MONITOR
+#define _PROP_MONITOR
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ *  @brief Worker threads running demoted (asynchronous) listeners.
+ *  @details Each task is posted with a key; tasks with the same key run on
+ * the same worker, in the order they were posted.
+ */
+struct listener_pool {
+public:
+  /**
+   *  @brief Starts the workers.
+   *
+   *  @param threads The amount of worker threads (at least one).
+   */
+  explicit listener_pool(unsigned threads = 1) {
+    if (threads == 0)
+      threads = 1;
+    for (unsigned i = 0; i < threads; i++)
+      workers.emplace_back(new worker);
+    for (auto &w : workers)
+      w->thread = std::thread([this, &self = *w]() { run(self); });
+  }
+
+  /**
+   *  @brief You can't copy a pool.
+   */
+  listener_pool(const listener_pool &) = delete;
+
+  /**
+   *  @brief Posts a task.
+   *
+   *  @param key The ordering key of the task.
+   *  @param task The task.
+   */
+  void post(std::size_t key, std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> guard(idle_lock);
+      pending++;
+    }
+    worker &w = *workers[key % workers.size()];
+    {
+      std::lock_guard<std::mutex> guard(w.lock);
+      w.tasks.push_back(std::move(task));
+    }
+    w.wake.notify_one();
+  }
+
+  /**
+   *  @brief Waits until all posted tasks have run.
+   */
+  void wait_idle() {
+    std::unique_lock<std::mutex> guard(idle_lock);
+    idle.wait(guard, [this]() { return pending == 0; });
+  }
+
+  /**
+   *  @brief Gets the amount of worker threads.
+   *  @return The amount of workers.
+   */
+  std::size_t size() const { return workers.size(); }
+
+  /**
+   *  @brief Runs all posted tasks, then stops the workers.
+   */
+  ~listener_pool() {
+    for (auto &w : workers) {
+      {
+        std::lock_guard<std::mutex> guard(w->lock);
+        w->stop = true;
+      }
+      w->wake.notify_one();
+    }
+    for (auto &w : workers)
+      w->thread.join();
+  }
+
+private:
+  struct worker {
+    std::mutex lock;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> tasks;
+    bool stop = false;
+    std::thread thread;
+  };
+
+  void run(worker &w) {
+    std::unique_lock<std::mutex> guard(w.lock);
+    for (;;) {
+      w.wake.wait(guard, [&w]() { return w.stop || !w.tasks.empty(); });
+      if (w.tasks.empty())
+        return;
+      std::function<void()> task = std::move(w.tasks.front());
+      w.tasks.pop_front();
+      guard.unlock();
+      task();
+      {
+        std::lock_guard<std::mutex> done(idle_lock);
+        if (--pending == 0)
+          idle.notify_all();
+      }
+      guard.lock();
+    }
+  }
+
+  std::vector<std::unique_ptr<worker>> workers;
+  std::mutex idle_lock;
+  std::condition_variable idle;
+  std::size_t pending = 0;
+};
+
+/**
+ *  @brief Configuration of listener monitoring on an event.
+ */
+struct listener_policy {
+  /** @brief The time a single listener call may take. */
+  std::chrono::nanoseconds budget = std::chrono::microseconds(100);
+  /** @brief The amount of consecutive calls over budget to flag a listener. */
+  unsigned strikes = 3;
+  /** @brief The pool to demote flagged listeners to, or `nullptr` to only
+   * flag them. */
+  listener_pool *pool = nullptr;
+};
+
+/**
+ *  @brief Statistics of a single listener of a monitored event.
+ */
+struct listener_stats {
+  /** @brief The index of the listener, in registration order. */
+  std::size_t index;
+  /** @brief The amount of calls (posts, once the listener is async). */
+  std::uint64_t calls;
+  /** @brief The total time spent in those calls, in ns. */
+  std::uint64_t total_ns;
+  /** @brief The longest call, in ns. */
+  std::uint64_t max_ns;
+  /** @brief The amount of calls over budget. */
+  std::uint64_t over_budget;
+  /** @brief Whether the listener went over budget too often. */
+  bool flagged;
+  /** @brief Whether the listener was moved to asynchronous delivery. */
+  bool async;
+};
+
+/**
+ * @brief Implementation details; not part of the public interface.
+ */
+namespace detail {
+/**
+ *  @brief Cheap monotonic tick counter (the TSC on x86).
+ */
+struct cycle_clock {
+  /**
+   *  @brief Reads the counter.
+   *  @return The current tick count.
+   */
+  static std::uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+  }
+
+  /**
+   *  @brief Gets the length of a tick, calibrated once (taking ~1ms).
+   *  @return The amount of ns per tick.
+   */
+  static double ns_per_tick() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const double ratio = []() {
+      auto start = std::chrono::steady_clock::now();
+      std::uint64_t ticks = now();
+      auto end = start;
+      while (end - start < std::chrono::milliseconds(1))
+        end = std::chrono::steady_clock::now();
+      std::uint64_t elapsed = now() - ticks;
+      double ns = std::chrono::duration<double, std::nano>(end - start).count();
+      return elapsed == 0 ? 1.0 : ns / elapsed;
+    }();
+    return ratio;
+#else
+    return 1.0;
+#endif
+  }
+};
+
+/**
+ *  @brief Timing state of a monitored event.
+ */
+struct listener_monitor {
+  /**
+   *  @brief Creates a new monitor.
+   *
+   *  @param policy The monitoring configuration.
+   */
+  explicit listener_monitor(const listener_policy &policy)
+      : policy{policy},
+        budget{static_cast<std::uint64_t>(policy.budget.count() /
+                                          cycle_clock::ns_per_tick())} {}
+
+  /**
+   *  @brief Makes sure there is a slot for every listener.
+   *
+   *  @param count The amount of listeners.
+   */
+  void track(std::size_t count) {
+    if (slots.size() < count)
+      slots.resize(count);
+  }
+
+  /**
+   *  @brief Accounts for a listener call.
+   *
+   *  @param i The index of the listener.
+   *  @param start The tick count before the call.
+   *  @return True if the listener should be demoted now.
+   */
+  bool finish(std::size_t i, std::uint64_t start) {
+    std::uint64_t elapsed = cycle_clock::now() - start;
+    slot &s = slots[i];
+    s.calls++;
+    s.total += elapsed;
+    if (elapsed > s.max)
+      s.max = elapsed;
+    if (elapsed <= budget) {
+      s.strikes = 0;
+      return false;
+    }
+    s.over_budget++;
+    if (s.async || ++s.strikes < policy.strikes)
+      return false;
+    s.flagged = true;
+    return policy.pool != nullptr;
+  }
+
+  /**
+   *  @brief Marks a listener as asynchronous.
+   *
+   *  @param i The index of the listener.
+   */
+  void demote(std::size_t i) { slots[i].async = true; }
+
+  /**
+   *  @brief Gets the statistics of all listeners.
+   *  @return The statistics, in registration order.
+   */
+  std::vector<listener_stats> stats() const {
+    double ratio = cycle_clock::ns_per_tick();
+    std::vector<listener_stats> result;
+    for (std::size_t i = 0; i < slots.size(); i++) {
+      const slot &s = slots[i];
+      result.push_back({i, s.calls, static_cast<std::uint64_t>(s.total * ratio),
+                        static_cast<std::uint64_t>(s.max * ratio),
+                        s.over_budget, s.flagged, s.async});
+    }
+    return result;
+  }
+
+  /** @brief The monitoring configuration. */
+  listener_policy policy;
+  /** @brief The budget, in ticks. */
+  std::uint64_t budget;
+
+private:
+  struct slot {
+    std::uint64_t calls = 0;
+    std::uint64_t total = 0;
+    std::uint64_t max = 0;
+    std::uint64_t over_budget = 0;
+    unsigned strikes = 0;
+    bool flagged = false;
+    bool async = false;
+  };
+
+  std::vector<slot> slots;
+};
+} // namespace detail
+} // namespace properties
+
+#endif /* _PROP_MONITOR */
@@ -0,0 +1,194 @@
+#ifndef _PROP_NO_ALLOC
+#define _PROP_NO_ALLOC
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ *  @brief Function called when memory is allocated inside a `no_alloc_scope`.
+ *  @details It is called with the requested size, before the allocation
+ * happens. It may throw (e.g. `std::bad_alloc`) to fail the allocation, or
+ * return to let it go through.
+ */
+using alloc_violation_handler = void (*)(std::size_t size);
+
+/**
+ * @brief Implementation details; not part of the public interface.
+ */
+namespace detail {
+inline void abort_on_allocation(std::size_t size) {
+  std::fprintf(stderr,
+               "properties: allocation of %zu bytes inside a no_alloc_scope\n",
+               size);
+  std::abort();
+}
+
+inline std::atomic<alloc_violation_handler> &violation_handler() {
+  static std::atomic<alloc_violation_handler> handler{&abort_on_allocation};
+  return handler;
+}
+
+struct alloc_guard_state {
+  unsigned depth = 0;
+  std::size_t violations = 0;
+};
+
+inline alloc_guard_state &alloc_guard() {
+  thread_local alloc_guard_state state;
+  return state;
+}
+
+/**
+ *  @brief Checks an allocation; called by the guarded `operator new`.
+ *
+ *  @param size The requested size.
+ */
+inline void check_allocation(std::size_t size) {
+  alloc_guard_state &state = alloc_guard();
+  if (state.depth == 0)
+    return;
+  state.violations++;
+  // allocations made by the handler itself aren't violations
+  unsigned depth = state.depth;
+  state.depth = 0;
+  struct restore {
+    alloc_guard_state &state;
+    unsigned depth;
+    ~restore() { state.depth = depth; }
+  } guard{state, depth};
+  violation_handler().load(std::memory_order_acquire)(size);
+}
+} // namespace detail
+
+/**
+ *  @brief Sets the function called on allocations inside a `no_alloc_scope`.
+ *  @details The default handler prints a message and aborts.
+ *
+ *  @param handler The new handler.
+ *  @return The previous handler.
+ */
+inline alloc_violation_handler
+set_alloc_violation_handler(alloc_violation_handler handler) {
+  return detail::violation_handler().exchange(handler,
+                                              std::memory_order_acq_rel);
+}
+
+/**
+ *  @brief Region of code that must not allocate memory.
+ *  @details While a scope is alive, every `operator new` on the same thread
+ * is a violation: it is counted and the violation handler is called. Scopes
+ * nest. This only has an effect in programs where exactly one translation
+ * unit expands `PROP_DEFINE_ALLOC_GUARD()`, which replaces the global
+ * allocation functions; it is meant for tests and debug builds.
+ *
+ * Typical use, proving a hot path allocation-free in steady state:
+ *
+ *     prop.set(1); // warm-up
+ *     {
+ *       properties::no_alloc_scope guard;
+ *       prop.set(2);
+ *       CHECK_EQ(guard.violations(), 0);
+ *     }
+ */
+struct no_alloc_scope {
+public:
+  /**
+   *  @brief Starts the scope.
+   */
+  no_alloc_scope() : start{detail::alloc_guard().violations} {
+    detail::alloc_guard().depth++;
+  }
+  /**
+   *  @brief You can't copy a scope.
+   */
+  no_alloc_scope(const no_alloc_scope &) = delete;
+
+  /**
+   *  @brief Gets the amount of allocations since the scope started.
+   *  @return The amount of violations.
+   */
+  std::size_t violations() const {
+    return detail::alloc_guard().violations - start;
+  }
+
+  /**
+   *  @brief Ends the scope.
+   */
+  ~no_alloc_scope() { detail::alloc_guard().depth--; }
+
+private:
+  std::size_t start;
+};
+} // namespace properties
+
+// GCC matches inlined replacements against the builtin operator new and
+// reports free() as mismatched
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#define PROP_ALLOC_GUARD_BEGIN                                                 \
+  _Pragma("GCC diagnostic push")                                               \
+      _Pragma("GCC diagnostic ignored \"-Wmismatched-new-delete\"")
+#define PROP_ALLOC_GUARD_END _Pragma("GCC diagnostic pop")
+#else
+#define PROP_ALLOC_GUARD_BEGIN
+#define PROP_ALLOC_GUARD_END
+#endif
+
+/**
+ *  @brief Defines the global allocation functions checking for
+ * `no_alloc_scope`s.
+ *  @details Expand this macro at namespace scope in exactly one translation
+ * unit of a program. The replacements allocate with `malloc` /
+ * `aligned_alloc` and release with `free`.
+ */
+#define PROP_DEFINE_ALLOC_GUARD()                                              \
+  PROP_ALLOC_GUARD_BEGIN                                                       \
+  void *operator new(std::size_t size) {                                       \
+    properties::detail::check_allocation(size);                                \
+    if (void *p = std::malloc(size ? size : 1))                                \
+      return p;                                                                \
+    throw std::bad_alloc();                                                    \
+  }                                                                            \
+  void *operator new[](std::size_t size) { return operator new(size); }        \
+  void *operator new(std::size_t size, const std::nothrow_t &) noexcept {      \
+    try {                                                                      \
+      return operator new(size);                                               \
+    } catch (...) {                                                            \
+      return nullptr;                                                          \
+    }                                                                          \
+  }                                                                            \
+  void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {    \
+    return operator new(size, std::nothrow);                                   \
+  }                                                                            \
+  void *operator new(std::size_t size, std::align_val_t align) {               \
+    properties::detail::check_allocation(size);                                \
+    std::size_t a = static_cast<std::size_t>(align);                           \
+    if (void *p = std::aligned_alloc(a, (size + a - 1) / a * a))               \
+      return p;                                                                \
+    throw std::bad_alloc();                                                    \
+  }                                                                            \
+  void *operator new[](std::size_t size, std::align_val_t align) {             \
+    return operator new(size, align);                                          \
+  }                                                                            \
+  void operator delete(void *p) noexcept { std::free(p); }                     \
+  void operator delete[](void *p) noexcept { std::free(p); }                   \
+  void operator delete(void *p, std::size_t) noexcept { std::free(p); }        \
+  void operator delete[](void *p, std::size_t) noexcept { std::free(p); }      \
+  void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }   \
+  void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); } \
+  void operator delete(void *p, std::size_t, std::align_val_t) noexcept {      \
+    std::free(p);                                                              \
+  }                                                                            \
+  void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {    \
+    std::free(p);                                                              \
+  }                                                                            \
+  PROP_ALLOC_GUARD_END                                                         \
+  static_assert(true, "")
+
+#endif /* _PROP_NO_ALLOC */
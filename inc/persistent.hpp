@@ -0,0 +1,660 @@
+#ifndef _PROP_PERSISTENT
+#define _PROP_PERSISTENT
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ *  @brief Persistent (immutable) vector.
+ *  @details The elements are stored in a 32-way radix balanced trie whose
+ * nodes are shared between versions. Copying a vector is an O(1) reference
+ * bump; every modification returns a new vector and only copies the O(log n)
+ * path to the modified element. Appending is amortized O(1) thanks to a tail
+ * buffer. Since versions never change, they can be held indefinitely and
+ * passed to other threads, which makes `property<persistent_vector<T>, true>`
+ * cheap to snapshot (`auto snapshot = prop.get();`).
+ *
+ *  @tparam T The type of the elements.
+ */
+template <typename T> struct persistent_vector {
+private:
+  struct node;
+  using node_ptr = std::shared_ptr<const node>;
+
+  static constexpr unsigned bits = 5;
+  static constexpr std::size_t width = std::size_t{1} << bits;
+  static constexpr std::size_t mask = width - 1;
+
+  struct node {
+    std::vector<node_ptr> children;
+    std::vector<T> values;
+  };
+
+public:
+  /**
+   *  @brief Iterator over the elements of a vector.
+   *  @details The iterator keeps the vector it iterates alive.
+   */
+  struct const_iterator {
+  public:
+    /** @brief Iterator category. */
+    using iterator_category = std::forward_iterator_tag;
+    /** @brief Value type. */
+    using value_type = T;
+    /** @brief Difference type. */
+    using difference_type = std::ptrdiff_t;
+    /** @brief Pointer type. */
+    using pointer = const T *;
+    /** @brief Reference type. */
+    using reference = const T &;
+
+    /**
+     *  @brief Gets the current element.
+     *  @return A constant reference to the element.
+     */
+    const T &operator*() const { return leaf->values[index & mask]; }
+    /**
+     *  @brief Gets the current element.
+     *  @return A pointer to the element.
+     */
+    const T *operator->() const { return &**this; }
+    /**
+     *  @brief Moves to the next element.
+     *  @return A reference to this iterator.
+     */
+    const_iterator &operator++() {
+      index++;
+      if ((index & mask) == 0 && index < vec.size())
+        leaf = vec.leaf_for(index);
+      return *this;
+    }
+    /**
+     *  @brief Compares two iterators.
+     *  @return True if the iterators point to the same element.
+     */
+    bool operator==(const const_iterator &other) const {
+      return index == other.index;
+    }
+    /**
+     *  @brief Compares two iterators.
+     *  @return True if the iterators point to different elements.
+     */
+    bool operator!=(const const_iterator &other) const {
+      return index != other.index;
+    }
+
+  private:
+    friend struct persistent_vector;
+    const_iterator(const persistent_vector &vec, std::size_t index)
+        : vec{vec}, index{index},
+          leaf{index < vec.size() ? vec.leaf_for(index) : nullptr} {}
+
+    persistent_vector vec;
+    std::size_t index;
+    const node *leaf;
+  };
+
+  /**
+   *  @brief Creates an empty vector.
+   */
+  persistent_vector()
+      : root{std::make_shared<const node>()},
+        tail{std::make_shared<const node>()} {}
+
+  /**
+   *  @brief Gets the amount of elements.
+   *  @return The size of the vector.
+   */
+  std::size_t size() const { return count; }
+  /**
+   *  @brief Checks whether the vector is empty.
+   *  @return True if the vector has no elements.
+   */
+  bool empty() const { return count == 0; }
+
+  /**
+   *  @brief Gets an element.
+   *  @details The index should be smaller than `size()`.
+   *
+   *  @param index The index of the element.
+   *  @return A constant reference to the element.
+   */
+  const T &operator[](std::size_t index) const {
+    return leaf_for(index)->values[index & mask];
+  }
+
+  /**
+   *  @brief Gets an iterator to the first element.
+   *  @return The iterator.
+   */
+  const_iterator begin() const { return const_iterator(*this, 0); }
+  /**
+   *  @brief Gets an iterator past the last element.
+   *  @return The iterator.
+   */
+  const_iterator end() const { return const_iterator(*this, count); }
+
+  /**
+   *  @brief Appends an element.
+   *
+   *  @param value The new element.
+   *  @return A new vector with the element appended.
+   */
+  persistent_vector push_back(T value) const {
+    persistent_vector result = *this;
+    if (count - tail_offset() < width) {
+      auto new_tail = std::make_shared<node>(*tail);
+      new_tail->values.push_back(std::move(value));
+      result.tail = std::move(new_tail);
+    } else {
+      if ((count >> bits) > (std::size_t{1} << shift)) {
+        auto new_root = std::make_shared<node>();
+        new_root->children.push_back(root);
+        new_root->children.push_back(new_path(shift, tail));
+        result.root = std::move(new_root);
+        result.shift = shift + bits;
+      } else {
+        result.root = push_tail(shift, root, tail);
+      }
+      auto new_tail = std::make_shared<node>();
+      new_tail->values.push_back(std::move(value));
+      result.tail = std::move(new_tail);
+    }
+    result.count++;
+    return result;
+  }
+
+  /**
+   *  @brief Replaces an element.
+   *  @details The index should be smaller than `size()`.
+   *
+   *  @param index The index of the element.
+   *  @param value The new element.
+   *  @return A new vector with the element replaced.
+   */
+  persistent_vector set(std::size_t index, T value) const {
+    persistent_vector result = *this;
+    if (index >= tail_offset()) {
+      auto new_tail = std::make_shared<node>(*tail);
+      new_tail->values[index & mask] = std::move(value);
+      result.tail = std::move(new_tail);
+    } else {
+      result.root = assoc(shift, root, index, std::move(value));
+    }
+    return result;
+  }
+
+  /**
+   *  @brief Removes the last element.
+   *  @details The vector should not be empty.
+   *
+   *  @return A new vector without the last element.
+   */
+  persistent_vector pop_back() const {
+    if (count == 1)
+      return persistent_vector();
+    persistent_vector result = *this;
+    if (count - tail_offset() > 1) {
+      auto new_tail = std::make_shared<node>(*tail);
+      new_tail->values.pop_back();
+      result.tail = std::move(new_tail);
+    } else {
+      result.tail = leaf_ptr_for(count - 2);
+      node_ptr new_root = pop_tail(shift, root);
+      if (!new_root)
+        new_root = std::make_shared<const node>();
+      if (shift > bits && new_root->children.size() == 1) {
+        result.root = new_root->children[0];
+        result.shift = shift - bits;
+      } else {
+        result.root = std::move(new_root);
+      }
+    }
+    result.count--;
+    return result;
+  }
+
+private:
+  std::size_t tail_offset() const {
+    return count < width ? 0 : ((count - 1) >> bits) << bits;
+  }
+
+  const node *leaf_for(std::size_t index) const {
+    if (index >= tail_offset())
+      return tail.get();
+    const node *current = root.get();
+    for (unsigned level = shift; level > 0; level -= bits)
+      current = current->children[(index >> level) & mask].get();
+    return current;
+  }
+
+  const node_ptr &leaf_ptr_for(std::size_t index) const {
+    const node_ptr *current = &root;
+    for (unsigned level = shift; level > 0; level -= bits)
+      current = &(*current)->children[(index >> level) & mask];
+    return *current;
+  }
+
+  node_ptr push_tail(unsigned level, const node_ptr &parent,
+                     const node_ptr &leaf) const {
+    auto result = std::make_shared<node>(*parent);
+    std::size_t sub = ((count - 1) >> level) & mask;
+    if (level == bits) {
+      result->children.push_back(leaf);
+    } else if (sub < parent->children.size()) {
+      result->children[sub] =
+          push_tail(level - bits, parent->children[sub], leaf);
+    } else {
+      result->children.push_back(new_path(level - bits, leaf));
+    }
+    return result;
+  }
+
+  node_ptr pop_tail(unsigned level, const node_ptr &parent) const {
+    std::size_t sub = ((count - 2) >> level) & mask;
+    if (level > bits) {
+      node_ptr child = pop_tail(level - bits, parent->children[sub]);
+      if (!child && sub == 0)
+        return nullptr;
+      auto result = std::make_shared<node>(*parent);
+      if (child)
+        result->children[sub] = std::move(child);
+      else
+        result->children.pop_back();
+      return result;
+    }
+    if (sub == 0)
+      return nullptr;
+    auto result = std::make_shared<node>(*parent);
+    result->children.pop_back();
+    return result;
+  }
+
+  static node_ptr new_path(unsigned level, const node_ptr &leaf) {
+    if (level == 0)
+      return leaf;
+    auto result = std::make_shared<node>();
+    result->children.push_back(new_path(level - bits, leaf));
+    return result;
+  }
+
+  static node_ptr assoc(unsigned level, const node_ptr &current,
+                        std::size_t index, T value) {
+    auto result = std::make_shared<node>(*current);
+    if (level == 0) {
+      result->values[index & mask] = std::move(value);
+    } else {
+      std::size_t sub = (index >> level) & mask;
+      result->children[sub] =
+          assoc(level - bits, current->children[sub], index, std::move(value));
+    }
+    return result;
+  }
+
+  std::size_t count = 0;
+  unsigned shift = bits;
+  node_ptr root;
+  node_ptr tail;
+};
+
+/**
+ *  @brief Persistent (immutable) hash map.
+ *  @details The entries are stored in a hash array mapped trie (in the
+ * compressed CHAMP layout) whose nodes are shared between versions. Copying a
+ * map is an O(1) reference bump; every modification returns a new map and
+ * only copies the O(log n) path to the modified entry. Since versions never
+ * change, they can be held indefinitely and passed to other threads, which
+ * makes `property<persistent_map<K, V>, true>` cheap to snapshot (`auto
+ * snapshot = prop.get();`).
+ *
+ *  @tparam K The type of the keys.
+ *  @tparam V The type of the values.
+ *  @tparam Hash The hash functor for the keys.
+ *  @tparam Eq The equality functor for the keys.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename Eq = std::equal_to<K>>
+struct persistent_map {
+private:
+  struct node;
+  using node_ptr = std::shared_ptr<const node>;
+  using entry = std::pair<K, V>;
+
+  static constexpr unsigned bits = 5;
+  static constexpr unsigned hash_bits = sizeof(std::size_t) * 8;
+
+  // Positions set in datamap hold an entry, positions set in nodemap hold a
+  // child node. Past the last level, data is an unordered collision bucket.
+  struct node {
+    std::uint32_t datamap = 0;
+    std::uint32_t nodemap = 0;
+    std::vector<entry> data;
+    std::vector<node_ptr> nodes;
+  };
+
+public:
+  /**
+   *  @brief Iterator over the entries of a map.
+   *  @details The iterator keeps the map it iterates alive. Entries are
+   * visited in an unspecified order.
+   */
+  struct const_iterator {
+  public:
+    /** @brief Iterator category. */
+    using iterator_category = std::forward_iterator_tag;
+    /** @brief Value type. */
+    using value_type = entry;
+    /** @brief Difference type. */
+    using difference_type = std::ptrdiff_t;
+    /** @brief Pointer type. */
+    using pointer = const entry *;
+    /** @brief Reference type. */
+    using reference = const entry &;
+
+    /**
+     *  @brief Gets the current entry.
+     *  @return A constant reference to the key-value pair.
+     */
+    const entry &operator*() const { return *current; }
+    /**
+     *  @brief Gets the current entry.
+     *  @return A pointer to the key-value pair.
+     */
+    const entry *operator->() const { return current; }
+    /**
+     *  @brief Moves to the next entry.
+     *  @return A reference to this iterator.
+     */
+    const_iterator &operator++() {
+      advance();
+      return *this;
+    }
+    /**
+     *  @brief Compares two iterators.
+     *  @return True if the iterators point to the same entry.
+     */
+    bool operator==(const const_iterator &other) const {
+      return current == other.current;
+    }
+    /**
+     *  @brief Compares two iterators.
+     *  @return True if the iterators point to different entries.
+     */
+    bool operator!=(const const_iterator &other) const {
+      return current != other.current;
+    }
+
+  private:
+    friend struct persistent_map;
+    struct frame {
+      const node *at;
+      std::size_t data;
+      std::size_t nodes;
+    };
+
+    const_iterator() = default;
+    explicit const_iterator(const node_ptr &root) : root{root} {
+      stack.push_back({root.get(), 0, 0});
+      advance();
+    }
+
+    void advance() {
+      while (!stack.empty()) {
+        frame &top = stack.back();
+        if (top.data < top.at->data.size()) {
+          current = &top.at->data[top.data++];
+          return;
+        }
+        if (top.nodes < top.at->nodes.size()) {
+          const node *child = top.at->nodes[top.nodes++].get();
+          stack.push_back({child, 0, 0});
+        } else {
+          stack.pop_back();
+        }
+      }
+      current = nullptr;
+    }
+
+    node_ptr root;
+    std::vector<frame> stack;
+    const entry *current = nullptr;
+  };
+
+  /**
+   *  @brief Creates an empty map.
+   */
+  persistent_map() : root{std::make_shared<const node>()} {}
+
+  /**
+   *  @brief Gets the amount of entries.
+   *  @return The size of the map.
+   */
+  std::size_t size() const { return count; }
+  /**
+   *  @brief Checks whether the map is empty.
+   *  @return True if the map has no entries.
+   */
+  bool empty() const { return count == 0; }
+
+  /**
+   *  @brief Looks up a key.
+   *
+   *  @param key The key to look up.
+   *  @return A pointer to the value, or `nullptr` if the key is not present.
+   */
+  const V *find(const K &key) const {
+    std::size_t hash = Hash{}(key);
+    const node *current = root.get();
+    for (unsigned shift = 0;; shift += bits) {
+      if (shift >= hash_bits) {
+        for (const auto &e : current->data)
+          if (Eq{}(e.first, key))
+            return &e.second;
+        return nullptr;
+      }
+      std::uint32_t bit = bit_for(hash, shift);
+      if (current->datamap & bit) {
+        const entry &e = current->data[index_of(current->datamap, bit)];
+        return Eq{}(e.first, key) ? &e.second : nullptr;
+      }
+      if (!(current->nodemap & bit))
+        return nullptr;
+      current = current->nodes[index_of(current->nodemap, bit)].get();
+    }
+  }
+
+  /**
+   *  @brief Checks whether a key is present.
+   *
+   *  @param key The key to look up.
+   *  @return True if the map contains the key.
+   */
+  bool contains(const K &key) const { return find(key) != nullptr; }
+
+  /**
+   *  @brief Inserts or replaces an entry.
+   *
+   *  @param key The key of the entry.
+   *  @param value The value of the entry.
+   *  @return A new map containing the entry.
+   */
+  persistent_map set(K key, V value) const {
+    bool added = false;
+    std::size_t hash = Hash{}(key);
+    persistent_map result = *this;
+    result.root = assoc(root, hash, 0, entry{std::move(key), std::move(value)},
+                        added);
+    if (added)
+      result.count++;
+    return result;
+  }
+
+  /**
+   *  @brief Removes an entry.
+   *
+   *  @param key The key of the entry.
+   *  @return A new map without the entry (or this map if the key is not
+   * present).
+   */
+  persistent_map erase(const K &key) const {
+    node_ptr new_root = dissoc(root, Hash{}(key), 0, key);
+    if (new_root == root)
+      return *this;
+    persistent_map result = *this;
+    result.root = std::move(new_root);
+    result.count--;
+    return result;
+  }
+
+  /**
+   *  @brief Gets an iterator to the first entry.
+   *  @return The iterator.
+   */
+  const_iterator begin() const { return const_iterator(root); }
+  /**
+   *  @brief Gets an iterator past the last entry.
+   *  @return The iterator.
+   */
+  const_iterator end() const { return const_iterator(); }
+
+private:
+  static std::uint32_t bit_for(std::size_t hash, unsigned shift) {
+    return std::uint32_t{1} << ((hash >> shift) & 31);
+  }
+
+  static std::size_t index_of(std::uint32_t map, std::uint32_t bit) {
+    return std::bitset<32>(map & (bit - 1)).count();
+  }
+
+  static node_ptr merge(entry first, std::size_t first_hash, entry second,
+                        std::size_t second_hash, unsigned shift) {
+    auto result = std::make_shared<node>();
+    if (shift >= hash_bits) {
+      result->data.push_back(std::move(first));
+      result->data.push_back(std::move(second));
+      return result;
+    }
+    std::uint32_t first_bit = bit_for(first_hash, shift);
+    std::uint32_t second_bit = bit_for(second_hash, shift);
+    if (first_bit == second_bit) {
+      result->nodemap = first_bit;
+      result->nodes.push_back(merge(std::move(first), first_hash,
+                                    std::move(second), second_hash,
+                                    shift + bits));
+    } else {
+      result->datamap = first_bit | second_bit;
+      if (first_bit > second_bit)
+        std::swap(first, second);
+      result->data.push_back(std::move(first));
+      result->data.push_back(std::move(second));
+    }
+    return result;
+  }
+
+  static node_ptr assoc(const node_ptr &current, std::size_t hash,
+                        unsigned shift, entry e, bool &added) {
+    auto result = std::make_shared<node>(*current);
+    if (shift >= hash_bits) {
+      for (auto &existing : result->data) {
+        if (Eq{}(existing.first, e.first)) {
+          existing.second = std::move(e.second);
+          return result;
+        }
+      }
+      result->data.push_back(std::move(e));
+      added = true;
+      return result;
+    }
+
+    std::uint32_t bit = bit_for(hash, shift);
+    if (current->datamap & bit) {
+      std::size_t at = index_of(current->datamap, bit);
+      entry &existing = result->data[at];
+      if (Eq{}(existing.first, e.first)) {
+        existing.second = std::move(e.second);
+        return result;
+      }
+      std::size_t existing_hash = Hash{}(existing.first);
+      node_ptr child = merge(std::move(existing), existing_hash, std::move(e),
+                             hash, shift + bits);
+      result->data.erase(result->data.begin() + at);
+      result->datamap &= ~bit;
+      result->nodemap |= bit;
+      result->nodes.insert(
+          result->nodes.begin() + index_of(result->nodemap, bit),
+          std::move(child));
+      added = true;
+    } else if (current->nodemap & bit) {
+      std::size_t at = index_of(current->nodemap, bit);
+      result->nodes[at] =
+          assoc(current->nodes[at], hash, shift + bits, std::move(e), added);
+    } else {
+      result->datamap |= bit;
+      result->data.insert(
+          result->data.begin() + index_of(result->datamap, bit), std::move(e));
+      added = true;
+    }
+    return result;
+  }
+
+  static node_ptr dissoc(const node_ptr &current, std::size_t hash,
+                         unsigned shift, const K &key) {
+    if (shift >= hash_bits) {
+      for (std::size_t i = 0; i < current->data.size(); i++) {
+        if (Eq{}(current->data[i].first, key)) {
+          auto result = std::make_shared<node>(*current);
+          result->data.erase(result->data.begin() + i);
+          return result;
+        }
+      }
+      return current;
+    }
+
+    std::uint32_t bit = bit_for(hash, shift);
+    if (current->datamap & bit) {
+      std::size_t at = index_of(current->datamap, bit);
+      if (!Eq{}(current->data[at].first, key))
+        return current;
+      auto result = std::make_shared<node>(*current);
+      result->data.erase(result->data.begin() + at);
+      result->datamap &= ~bit;
+      return result;
+    }
+    if (!(current->nodemap & bit))
+      return current;
+
+    std::size_t at = index_of(current->nodemap, bit);
+    node_ptr child = dissoc(current->nodes[at], hash, shift + bits, key);
+    if (child == current->nodes[at])
+      return current;
+    auto result = std::make_shared<node>(*current);
+    if (child->nodes.empty() && child->data.size() == 1) {
+      // Keep the trie canonical: inline a child that holds a single entry.
+      result->nodes.erase(result->nodes.begin() + at);
+      result->nodemap &= ~bit;
+      result->datamap |= bit;
+      result->data.insert(result->data.begin() +
+                              index_of(result->datamap, bit),
+                          child->data.front());
+    } else {
+      result->nodes[at] = std::move(child);
+    }
+    return result;
+  }
+
+  std::size_t count = 0;
+  node_ptr root;
+};
+} // namespace properties
+
+#endif /* _PROP_PERSISTENT */
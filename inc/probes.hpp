@@ -0,0 +1,47 @@
+#ifndef _PROP_PROBES
+#define _PROP_PROBES
+
+/**
+ *  @file probes.hpp
+ *  @brief Optional USDT (user-level static tracing) probes.
+ *  @details When `PROP_ENABLE_USDT` is defined, events fire the following
+ * probes under the `prop` provider (this needs `<sys/sdt.h>` from SystemTap;
+ * without it, the build fails rather than silently dropping the probes):
+ *
+ *  - `trigger_begin(event, listeners)` and `trigger_end(event, listeners)`
+ * around each trigger;
+ *  - `listener_begin(event, index)` and `listener_end(event, index)` around
+ * each callback.
+ *
+ * `event` is the address of the event, which identifies a property (its
+ * change event is a member). Each probe is a single `nop` in the code and a
+ * note in the binary; there is no runtime dependency. Attach with `perf
+ * probe` or bpftrace (see `tools/prop_latency.bt`). Without
+ * `PROP_ENABLE_USDT`, the probes expand to nothing and their arguments are
+ * not evaluated.
+ */
+
+#ifdef PROP_ENABLE_USDT
+#if defined(__has_include)
+#if !__has_include(<sys/sdt.h>)
+#error "PROP_ENABLE_USDT requires <sys/sdt.h> (systemtap-sdt-dev)"
+#endif
+#endif
+#include <sys/sdt.h>
+#define PROP_PROBES_ENABLED 1
+#endif
+
+#ifdef PROP_PROBES_ENABLED
+/**
+ *  @brief Fires a probe with two arguments.
+ *
+ *  @param name The name of the probe (under the `prop` provider).
+ *  @param a The first argument.
+ *  @param b The second argument.
+ */
+#define PROP_PROBE2(name, a, b) STAP_PROBE2(prop, name, a, b)
+#else
+#define PROP_PROBE2(name, a, b) ((void)0)
+#endif
+
+#endif /* _PROP_PROBES */
@@ -0,0 +1,224 @@
+#ifndef _PROP_PROMETHEUS
+#define _PROP_PROMETHEUS
+
+#include "event.hpp"
+#include "metrics.hpp"
+#include "property.hpp"
+
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ *  @brief Named event metrics, exported in the Prometheus text format.
+ *  @details Tracking an event (or a property's change event) attaches a
+ * fresh `event_metrics` to it under a name. `render()` collects all metrics
+ * and formats them; collecting only reads the per-thread shards, so it never
+ * blocks triggering threads. The following metrics are exported, each with an
+ * `event` label:
+ *
+ *  - `prop_event_triggers_total` (counter): the amount of triggers;
+ *  - `prop_event_listener_calls_total` (counter): the amount of listener
+ * calls; divided by the triggers, this is the average batch size;
+ *  - `prop_event_listeners` (gauge): the amount of registered listeners;
+ *  - `prop_event_dispatch_seconds` (summary): the time a trigger takes, with
+ * 0.5, 0.9, 0.99 and 0.999 quantiles estimated from a log2 histogram.
+ *
+ * The registry must outlive the tracked events.
+ */
+struct metrics_registry {
+public:
+  /**
+   *  @brief Creates an empty registry.
+   */
+  metrics_registry() = default;
+  /**
+   *  @brief You can't copy a registry.
+   */
+  metrics_registry(const metrics_registry &) = delete;
+
+  /**
+   *  @brief Starts counting an event.
+   *
+   *  @tparam Out The type of the event.
+   *  @param name The name of the event (the `event` label).
+   *  @param target The event.
+   *  @return The metrics of the event.
+   */
+  template <typename Out>
+  event_metrics &track(const std::string &name, event<Out> &target) {
+    event_metrics &metrics = add(name);
+    target.attach_metrics(&metrics);
+    return metrics;
+  }
+
+  /**
+   *  @brief Starts counting the change event of a property.
+   *
+   *  @tparam T The type of the value.
+   *  @tparam copy The copy state of the property.
+   *  @param name The name of the property (the `event` label).
+   *  @param target The property.
+   *  @return The metrics of the property.
+   */
+  template <typename T, bool copy>
+  event_metrics &track(const std::string &name, property<T, copy> &target) {
+    event_metrics &metrics = add(name);
+    target.attach_metrics(&metrics);
+    return metrics;
+  }
+
+  /**
+   *  @brief Renders all metrics in the Prometheus text exposition format.
+   *  @return The metrics text.
+   */
+  std::string render() const {
+    std::vector<std::pair<std::string, event_metrics::snapshot>> snapshots;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (const auto &entry : entries)
+        snapshots.emplace_back(entry.name, entry.metrics.collect());
+    }
+    double seconds = detail::cycle_clock::ns_per_tick() / 1e9;
+
+    std::string out;
+    header(out, "prop_event_triggers_total", "counter",
+           "Number of times the event was triggered.");
+    for (const auto &[name, s] : snapshots)
+      line(out, "prop_event_triggers_total", name, "", s.triggers);
+
+    header(out, "prop_event_listener_calls_total", "counter",
+           "Number of listener calls made by triggers of the event.");
+    for (const auto &[name, s] : snapshots)
+      line(out, "prop_event_listener_calls_total", name, "", s.listener_calls);
+
+    header(out, "prop_event_listeners", "gauge",
+           "Number of listeners registered on the event.");
+    for (const auto &[name, s] : snapshots)
+      line(out, "prop_event_listeners", name, "", s.listeners);
+
+    header(out, "prop_event_dispatch_seconds", "summary",
+           "Time taken by a trigger of the event, including all listeners.");
+    for (const auto &[name, s] : snapshots) {
+      for (const auto &[label, q] : quantiles)
+        line(out, "prop_event_dispatch_seconds", name,
+             std::string(",quantile=\"") + label + "\"",
+             quantile(s, q) * seconds);
+      line(out, "prop_event_dispatch_seconds_sum", name, "",
+           s.latency * seconds);
+      line(out, "prop_event_dispatch_seconds_count", name, "", s.triggers);
+    }
+    return out;
+  }
+
+  /**
+   *  @brief Renders all metrics to a file (e.g. for the node exporter's
+   * textfile collector).
+   *  @details The file is written to a temporary name first and renamed into
+   * place, so readers never see a partial file.
+   *
+   *  @param path The path of the file.
+   *  @return True if the file was written, otherwise false.
+   */
+  bool write(const std::filesystem::path &path) const {
+    auto temporary = path;
+    temporary += ".tmp";
+    {
+      std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+      if (!(out << render()))
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(temporary, path, ec);
+    return !ec;
+  }
+
+  /**
+   *  @brief Destroys the registry.
+   */
+  ~metrics_registry() = default;
+
+private:
+  static constexpr std::pair<const char *, double> quantiles[] = {
+      {"0.5", 0.5}, {"0.9", 0.9}, {"0.99", 0.99}, {"0.999", 0.999}};
+
+  struct entry {
+    explicit entry(std::string name) : name{std::move(name)} {}
+    std::string name;
+    event_metrics metrics;
+  };
+
+  event_metrics &add(const std::string &name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.emplace_back(name).metrics;
+  }
+
+  static double quantile(const event_metrics::snapshot &s, double q) {
+    std::uint64_t total = 0;
+    for (auto count : s.histogram)
+      total += count;
+    if (total == 0)
+      return 0;
+    double rank = q * total;
+    double seen = 0;
+    for (std::size_t i = 0; i < event_metrics::buckets; i++) {
+      if (s.histogram[i] == 0)
+        continue;
+      double low = i == 0 ? 0 : static_cast<double>(1ull << (i - 1));
+      double high = static_cast<double>(1ull << i);
+      if (seen + s.histogram[i] >= rank)
+        return low + (high - low) * (rank - seen) / s.histogram[i];
+      seen += s.histogram[i];
+    }
+    return static_cast<double>(1ull << (event_metrics::buckets - 1));
+  }
+
+  static void header(std::string &out, const char *metric, const char *type,
+                     const char *help) {
+    out += std::string("# HELP ") + metric + " " + help + "\n";
+    out += std::string("# TYPE ") + metric + " " + type + "\n";
+  }
+
+  template <typename V>
+  static void line(std::string &out, const char *metric,
+                   const std::string &name, const std::string &labels,
+                   V value) {
+    out += metric;
+    out += "{event=\"";
+    for (char c : name) {
+      if (c == '\\' || c == '"')
+        out += '\\';
+      if (c == '\n')
+        out += "\\n";
+      else
+        out += c;
+    }
+    out += '"';
+    out += labels;
+    out += "} ";
+    if constexpr (std::is_floating_point<V>::value) {
+      char buffer[32];
+      std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+      out += buffer;
+    } else {
+      out += std::to_string(value);
+    }
+    out += "\n";
+  }
+
+  mutable std::mutex mutex;
+  std::deque<entry> entries;
+};
+} // namespace properties
+
+#endif /* _PROP_PROMETHEUS */
@@ -3,6 +3,10 @@
 
 #include "event.hpp"
 
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
 /**
  * @brief Main namespace for the properties library.
  */
@@ -173,9 +177,50 @@ public:
    * will be called with a reference to the value. Modifying that value will
    * never trigger the event.
    *
-   * @param callback The callback to add to the event.
+   *  @tparam Call The type of the callback. It should be copyable and
+   * callable with a `T &`.
+   *  @param callback The callback to add to the event.
+   */
+  template <typename Call, typename _ = typename std::enable_if<
+                               std::is_invocable<Call &, T &>::value>::type>
+  void operator+(Call &&callback) {
+    typename std::decay<Call>::type listener(std::forward<Call>(callback));
+    _set + listener;
+  }
+
+  /**
+   *  @brief Starts timing the callbacks of the event.
+   *  @details See `event::monitor_listeners`.
+   *
+   *  @param policy The monitoring configuration.
+   */
+  void monitor_listeners(const listener_policy &policy) {
+    _set.monitor_listeners(policy);
+  }
+  /**
+   *  @brief Gets the statistics of the callbacks of the event.
+   *  @return The statistics, or nothing if the event isn't monitored.
    */
-  void operator+(typename event<T &>::Callable callback) { _set + callback; }
+  std::vector<listener_stats> listener_statistics() const {
+    return _set.listener_statistics();
+  }
+  /**
+   *  @brief Counts the triggers of the event.
+   *  @details See `event::attach_metrics`.
+   *
+   *  @param target The metrics to count into, or `nullptr` to stop counting.
+   */
+  void attach_metrics(event_metrics *target) { _set.attach_metrics(target); }
+  /**
+   *  @brief Traces the triggers of the event.
+   *  @details See `event::attach_tracer`.
+   *
+   *  @param target The tracer, or `nullptr` to stop tracing.
+   *  @param node The identifier passed to the tracer.
+   */
+  void attach_tracer(trigger_tracer *target, std::uint32_t node) {
+    _set.attach_tracer(target, node);
+  }
 
   /**
    *  @brief Destroys the property.
@@ -319,9 +364,50 @@ public:
    * will be called with a reference to the value. Modifying that value will
    * never trigger the event.
    *
-   * @param callback The callback to add to the event.
+   *  @tparam Call The type of the callback. It should be copyable and
+   * callable with a `T &`.
+   *  @param callback The callback to add to the event.
    */
-  void operator+(typename event<T &>::Callable callback) { _set + callback; }
+  template <typename Call, typename _ = typename std::enable_if<
+                               std::is_invocable<Call &, T &>::value>::type>
+  void operator+(Call &&callback) {
+    typename std::decay<Call>::type listener(std::forward<Call>(callback));
+    _set + listener;
+  }
+
+  /**
+   *  @brief Starts timing the callbacks of the event.
+   *  @details See `event::monitor_listeners`.
+   *
+   *  @param policy The monitoring configuration.
+   */
+  void monitor_listeners(const listener_policy &policy) {
+    _set.monitor_listeners(policy);
+  }
+  /**
+   *  @brief Gets the statistics of the callbacks of the event.
+   *  @return The statistics, or nothing if the event isn't monitored.
+   */
+  std::vector<listener_stats> listener_statistics() const {
+    return _set.listener_statistics();
+  }
+  /**
+   *  @brief Counts the triggers of the event.
+   *  @details See `event::attach_metrics`.
+   *
+   *  @param target The metrics to count into, or `nullptr` to stop counting.
+   */
+  void attach_metrics(event_metrics *target) { _set.attach_metrics(target); }
+  /**
+   *  @brief Traces the triggers of the event.
+   *  @details See `event::attach_tracer`.
+   *
+   *  @param target The tracer, or `nullptr` to stop tracing.
+   *  @param node The identifier passed to the tracer.
+   */
+  void attach_tracer(trigger_tracer *target, std::uint32_t node) {
+    _set.attach_tracer(target, node);
+  }
 
   /**
    *  @brief Destroys the property.
@@ -0,0 +1,288 @@
+#ifndef _PROP_RECORDER
+#define _PROP_RECORDER
+
+#include "property.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ *  @brief Lock-free ring buffer between one producer and one consumer thread.
+ *  @details The producer and consumer indices live on separate cache lines,
+ * and each side keeps a cached copy of the other side's index so it only
+ * touches the shared line when the ring looks full (or holds fewer elements
+ * than requested). The producer publishes its index once every `Batch`
+ * pushes (or on `flush()`); the consumer publishes its index once per read.
+ *
+ *  @tparam T The type of the elements; it should be trivially copyable.
+ *  @tparam Capacity The amount of elements; it should be a power of two.
+ *  @tparam Batch The amount of pushes per producer publication.
+ */
+template <typename T, std::size_t Capacity, std::size_t Batch = 32>
+struct spsc_ring {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "spsc_ring: T should be trivially copyable");
+  static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0,
+                "spsc_ring: Capacity should be a power of two");
+  static_assert(Batch != 0 && Batch <= Capacity,
+                "spsc_ring: Batch should be between 1 and Capacity");
+
+public:
+  /**
+   *  @brief Creates an empty ring.
+   */
+  spsc_ring() : slots{new T[Capacity]} {}
+
+  /**
+   *  @brief You can't copy a ring.
+   */
+  spsc_ring(const spsc_ring &) = delete;
+
+  /**
+   *  @brief Pushes an element (producer only).
+   *
+   *  @param value The element.
+   *  @return True if the element was pushed, false if the ring is full.
+   */
+  bool push(const T &value) {
+    if (producer.head - producer.cached_tail == Capacity) {
+      producer.cached_tail = tail.load(std::memory_order_acquire);
+      if (producer.head - producer.cached_tail == Capacity)
+        return false;
+    }
+    slots[producer.head & (Capacity - 1)] = value;
+    producer.head++;
+    if (producer.head - producer.published >= Batch)
+      flush();
+    return true;
+  }
+
+  /**
+   *  @brief Makes all pushed elements visible to the consumer (producer
+   * only).
+   */
+  void flush() {
+    producer.published = producer.head;
+    head.store(producer.head, std::memory_order_release);
+  }
+
+  /**
+   *  @brief Reads published elements (consumer only).
+   *
+   *  @param out The buffer to read into.
+   *  @param max The maximum amount of elements to read.
+   *  @return The amount of elements read.
+   */
+  std::size_t read(T *out, std::size_t max) {
+    std::size_t count = available(max);
+    for (std::size_t i = 0; i < count; i++)
+      out[i] = slots[(consumer.tail + i) & (Capacity - 1)];
+    consume(count);
+    return count;
+  }
+
+  /**
+   *  @brief Calls a function for each published element (consumer only).
+   *
+   *  @tparam F The type of the function.
+   *  @param func The function, called with a constant reference to each
+   * element.
+   *  @param max The maximum amount of elements to read.
+   *  @return The amount of elements read.
+   */
+  template <typename F>
+  std::size_t drain(F &&func, std::size_t max = Capacity) {
+    std::size_t count = available(max);
+    for (std::size_t i = 0; i < count; i++)
+      func(static_cast<const T &>(
+          slots[(consumer.tail + i) & (Capacity - 1)]));
+    consume(count);
+    return count;
+  }
+
+  /**
+   *  @brief Destroys the ring.
+   */
+  ~spsc_ring() = default;
+
+private:
+  std::size_t available(std::size_t max) {
+    if (consumer.cached_head - consumer.tail < max)
+      consumer.cached_head = head.load(std::memory_order_acquire);
+    std::size_t count = consumer.cached_head - consumer.tail;
+    return count < max ? count : max;
+  }
+
+  void consume(std::size_t count) {
+    if (count == 0)
+      return;
+    consumer.tail += count;
+    tail.store(consumer.tail, std::memory_order_release);
+  }
+
+  struct alignas(64) producer_state {
+    std::size_t head = 0;
+    std::size_t published = 0;
+    std::size_t cached_tail = 0;
+  };
+  struct alignas(64) consumer_state {
+    std::size_t tail = 0;
+    std::size_t cached_head = 0;
+  };
+
+  alignas(64) std::atomic<std::size_t> head{0};
+  alignas(64) std::atomic<std::size_t> tail{0};
+  producer_state producer;
+  consumer_state consumer;
+  std::unique_ptr<T[]> slots;
+};
+
+/**
+ *  @brief Compact record of a property change.
+ *  @details The value is stored as its object representation; values of up
+ * to `capacity` bytes fit.
+ */
+struct change_record {
+  /** @brief The maximum size of a value. */
+  static constexpr std::size_t capacity = 24;
+
+  /** @brief The identifier of the property. */
+  std::uint32_t id;
+  /** @brief The size of the value. */
+  std::uint32_t size;
+  /** @brief The bytes of the value. */
+  unsigned char bytes[capacity];
+
+  /**
+   *  @brief Recovers the value.
+   *
+   *  @tparam T The type of the value.
+   *  @return The value.
+   */
+  template <typename T> T as() const {
+    static_assert(std::is_trivially_copyable<T>::value &&
+                      sizeof(T) <= capacity,
+                  "change_record: T doesn't fit in a record");
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+  }
+};
+
+/**
+ *  @brief Records every change of a set of properties for another thread.
+ *  @details Watched properties push a `change_record` into an `spsc_ring` on
+ * each change, on the thread that writes them (which should always be the
+ * same thread). Another thread reads the records in batches. When the ring is
+ * full, records are dropped and counted instead of blocking the writer.
+ *
+ *  @tparam Capacity The amount of records in the ring (a power of two).
+ *  @tparam Batch The amount of records per producer publication.
+ */
+template <std::size_t Capacity = 4096, std::size_t Batch = 32>
+struct change_recorder {
+public:
+  /**
+   *  @brief Creates a new recorder.
+   */
+  change_recorder() = default;
+  /**
+   *  @brief You can't copy a recorder.
+   */
+  change_recorder(const change_recorder &) = delete;
+
+  /**
+   *  @brief Records all changes of a property.
+   *
+   *  @tparam T The type of the value; it should be trivially copyable and at
+   * most `change_record::capacity` bytes.
+   *  @tparam copy The copy state of the property.
+   *  @param prop The property to watch.
+   *  @return The identifier of the property in the records.
+   */
+  template <typename T, bool copy>
+  std::uint32_t watch(property<T, copy> &prop) {
+    std::uint32_t id = next_id++;
+    prop + [this, id](T &value) { record(id, value); };
+    return id;
+  }
+
+  /**
+   *  @brief Records a change (producer only).
+   *
+   *  @tparam T The type of the value.
+   *  @param id The identifier of the property.
+   *  @param value The new value.
+   */
+  template <typename T> void record(std::uint32_t id, const T &value) {
+    static_assert(std::is_trivially_copyable<T>::value &&
+                      sizeof(T) <= change_record::capacity,
+                  "change_recorder: T doesn't fit in a record");
+    change_record r;
+    r.id = id;
+    r.size = sizeof(T);
+    std::memcpy(r.bytes, &value, sizeof(T));
+    // only the producer writes the counter, so no read-modify-write is needed
+    if (!ring.push(r))
+      drops.store(drops.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+  }
+
+  /**
+   *  @brief Makes all records visible to the consumer (producer only).
+   */
+  void flush() { ring.flush(); }
+  /**
+   *  @brief Gets the amount of records dropped because the ring was full.
+   *  @details This can be called from any thread.
+   *
+   *  @return The amount of dropped records.
+   */
+  std::size_t dropped() const {
+    return drops.load(std::memory_order_relaxed);
+  }
+
+  /**
+   *  @brief Reads records (consumer only).
+   *
+   *  @param out The buffer to read into.
+   *  @param max The maximum amount of records to read.
+   *  @return The amount of records read.
+   */
+  std::size_t read(change_record *out, std::size_t max) {
+    return ring.read(out, max);
+  }
+  /**
+   *  @brief Calls a function for each record (consumer only).
+   *
+   *  @tparam F The type of the function.
+   *  @param func The function, called with a constant reference to each
+   * record.
+   *  @return The amount of records read.
+   */
+  template <typename F> std::size_t drain(F &&func) {
+    return ring.drain(std::forward<F>(func));
+  }
+
+  /**
+   *  @brief Destroys the recorder.
+   */
+  ~change_recorder() = default;
+
+private:
+  spsc_ring<change_record, Capacity, Batch> ring;
+  std::uint32_t next_id = 0;
+  std::atomic<std::size_t> drops{0};
+};
+} // namespace properties
+
+#endif /* _PROP_RECORDER */
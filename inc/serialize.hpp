@@ -0,0 +1,164 @@
+#ifndef _PROP_SERIALIZE
+#define _PROP_SERIALIZE
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ *  @brief Binary serializer.
+ *  @details The serializer turns values into bytes and back. The default
+ * implementation copies the object representation of types whose equal
+ * values have equal bytes (no padding), and of `float` and `double`, so the
+ * bytes can be fingerprinted. Other types, including padded structs, need a
+ * specialization with the same two static functions (`std::string` and
+ * `std::vector` are provided).
+ *
+ *  @tparam T The type of the values.
+ *  @tparam Enable Unused; allows partial specializations using SFINAE.
+ */
+template <typename T, typename Enable = void> struct serializer {
+  static_assert(std::has_unique_object_representations<T>::value ||
+                    std::is_same<T, float>::value ||
+                    std::is_same<T, double>::value,
+                "serializer: specialize properties::serializer for this type");
+
+  /**
+   *  @brief Appends the bytes of a value to a buffer.
+   *
+   *  @param out The buffer to append to.
+   *  @param value The value to serialize.
+   */
+  static void write(std::string &out, const T &value) {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  /**
+   *  @brief Reads a value from the front of a buffer.
+   *  @details On success, the bytes that were read are removed from the
+   * buffer.
+   *
+   *  @param in The buffer to read from.
+   *  @param value The value to read into.
+   *  @return True if a value could be read, otherwise false.
+   */
+  static bool read(std::string_view &in, T &value) {
+    if (in.size() < sizeof(T))
+      return false;
+    std::memcpy(&value, in.data(), sizeof(T));
+    in.remove_prefix(sizeof(T));
+    return true;
+  }
+};
+
+/**
+ *  @brief Binary serializer for strings.
+ *  @details Strings are written as their 64-bit length followed by their
+ * characters.
+ */
+template <> struct serializer<std::string> {
+  /**
+   *  @brief Appends the bytes of a string to a buffer.
+   *
+   *  @param out The buffer to append to.
+   *  @param value The string to serialize.
+   */
+  static void write(std::string &out, const std::string &value) {
+    serializer<std::uint64_t>::write(out, value.size());
+    out.append(value);
+  }
+
+  /**
+   *  @brief Reads a string from the front of a buffer.
+   *
+   *  @param in The buffer to read from.
+   *  @param value The string to read into.
+   *  @return True if a string could be read, otherwise false.
+   */
+  static bool read(std::string_view &in, std::string &value) {
+    std::uint64_t size;
+    if (!serializer<std::uint64_t>::read(in, size) || in.size() < size)
+      return false;
+    value.assign(in.data(), size);
+    in.remove_prefix(size);
+    return true;
+  }
+};
+
+/**
+ *  @brief Binary serializer for vectors.
+ *  @details Vectors are written as their 64-bit length followed by each of
+ * their elements.
+ *
+ *  @tparam T The element type.
+ */
+template <typename T> struct serializer<std::vector<T>> {
+  /**
+   *  @brief Appends the bytes of a vector to a buffer.
+   *
+   *  @param out The buffer to append to.
+   *  @param value The vector to serialize.
+   */
+  static void write(std::string &out, const std::vector<T> &value) {
+    serializer<std::uint64_t>::write(out, value.size());
+    for (const auto &element : value)
+      serializer<T>::write(out, element);
+  }
+
+  /**
+   *  @brief Reads a vector from the front of a buffer.
+   *
+   *  @param in The buffer to read from.
+   *  @param value The vector to read into.
+   *  @return True if a vector could be read, otherwise false.
+   */
+  static bool read(std::string_view &in, std::vector<T> &value) {
+    std::uint64_t size;
+    if (!serializer<std::uint64_t>::read(in, size))
+      return false;
+    value.clear();
+    for (std::uint64_t i = 0; i < size; i++) {
+      T element;
+      if (!serializer<T>::read(in, element))
+        return false;
+      value.push_back(std::move(element));
+    }
+    return true;
+  }
+};
+
+/**
+ *  @brief Serializes a value into a new buffer.
+ *
+ *  @tparam T The type of the value.
+ *  @param value The value to serialize.
+ *  @return The bytes of the value.
+ */
+template <typename T> std::string serialize(const T &value) {
+  std::string out;
+  serializer<T>::write(out, value);
+  return out;
+}
+
+/**
+ *  @brief Deserializes a value from a buffer.
+ *  @details The buffer should contain exactly one value.
+ *
+ *  @tparam T The type of the value.
+ *  @param in The bytes of the value.
+ *  @param value The value to read into.
+ *  @return True if the buffer held exactly one value, otherwise false.
+ */
+template <typename T> bool deserialize(std::string_view in, T &value) {
+  return serializer<T>::read(in, value) && in.empty();
+}
+} // namespace properties
+
+#endif /* _PROP_SERIALIZE */
@@ -0,0 +1,273 @@
+#ifndef _PROP_SHARED_VALUE
+#define _PROP_SHARED_VALUE
+
+#include "event.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ * @brief Implementation details; not part of the public interface.
+ */
+namespace detail {
+/**
+ *  @brief Hazard pointer record.
+ *  @details Each thread owns one record while it is alive. A non-null pointer
+ * in the record protects that object from being reclaimed. Records are padded
+ * to a cache line so readers on different threads never share one.
+ */
+struct alignas(64) hazard_record {
+  /** @brief The protected pointer (or `nullptr`). */
+  std::atomic<const void *> pointer{nullptr};
+  /** @brief Whether a thread owns this record. */
+  std::atomic<bool> active{false};
+  /** @brief The next record in the global list. */
+  hazard_record *next = nullptr;
+};
+
+/**
+ *  @brief Global list of hazard pointer records.
+ *  @details Records are never freed, only reused by later threads, so the list
+ * can be walked without synchronization.
+ */
+struct hazard_list {
+public:
+  /**
+   *  @brief Claims a free record (or allocates a new one).
+   *  @return The claimed record.
+   */
+  hazard_record *acquire() {
+    for (hazard_record *r = head.load(); r != nullptr; r = r->next) {
+      bool expected = false;
+      if (!r->active.load(std::memory_order_relaxed) &&
+          r->active.compare_exchange_strong(expected, true))
+        return r;
+    }
+    auto *record = new hazard_record;
+    record->active.store(true, std::memory_order_relaxed);
+    record->next = head.load();
+    while (!head.compare_exchange_weak(record->next, record)) {
+    }
+    return record;
+  }
+
+  /**
+   *  @brief Releases a record for use by other threads.
+   *
+   *  @param record The record to release.
+   */
+  void release(hazard_record *record) {
+    record->pointer.store(nullptr);
+    record->active.store(false);
+  }
+
+  /**
+   *  @brief Collects all currently protected pointers.
+   *  @return The protected pointers, sorted.
+   */
+  std::vector<const void *> protected_pointers() const {
+    std::vector<const void *> result;
+    for (hazard_record *r = head.load(); r != nullptr; r = r->next)
+      if (const void *p = r->pointer.load())
+        result.push_back(p);
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+private:
+  std::atomic<hazard_record *> head{nullptr};
+};
+
+/**
+ *  @brief Gets the global hazard pointer list.
+ *  @return The list.
+ */
+inline hazard_list &hazards() {
+  static hazard_list list;
+  return list;
+}
+
+/**
+ *  @brief Gets the hazard pointer record of the calling thread.
+ *  @details The record is claimed on first use and released when the thread
+ * exits.
+ *
+ *  @return The record.
+ */
+inline hazard_record &thread_hazard() {
+  struct owner {
+    hazard_record *record = hazards().acquire();
+    ~owner() { hazards().release(record); }
+  };
+  thread_local owner current;
+  return *current.record;
+}
+} // namespace detail
+
+/**
+ *  @brief Property holding an immutable, shared value.
+ *  @details This type holds a `std::shared_ptr<const T>` that can be read from
+ * any amount of threads while writers publish new instances. Readers protect
+ * the current instance with a per-thread hazard pointer instead of taking a
+ * lock, so they never block each other or the writers; reads only retry while
+ * a write is being published at the same moment. `read(func)` doesn't even
+ * touch the reference count of the value, so its throughput scales with the
+ * amount of reader threads. `get()` hands out a snapshot that can be held
+ * indefinitely.
+ *
+ * Writers publish the new instance first, then trigger the change event.
+ * Callbacks should be added before the property is shared between threads.
+ *
+ *  @tparam T The type of the value.
+ */
+template <typename T> struct shared_value_property {
+public:
+  /**
+   *  @brief The pointer type is an alias for `std::shared_ptr<const T>`.
+   */
+  using pointer = std::shared_ptr<const T>;
+
+  /**
+   *  @brief Creates a new property holding an existing instance.
+   *
+   *  @param value The initial instance.
+   */
+  explicit shared_value_property(pointer value)
+      : current{new holder{std::move(value)}} {}
+  /**
+   *  @brief Creates a new property holding a copy of a value.
+   *
+   *  @param value The initial value.
+   */
+  explicit shared_value_property(T value)
+      : shared_value_property(std::make_shared<const T>(std::move(value))) {}
+
+  /**
+   *  @brief You can't copy a shared value property.
+   */
+  shared_value_property(const shared_value_property &) = delete;
+  /**
+   *  @brief You can't move a shared value property.
+   */
+  shared_value_property(shared_value_property &&) = delete;
+
+  /**
+   *  @brief Gets a snapshot of the current value.
+   *  @details The snapshot stays valid (and unchanged) for as long as it is
+   * held, regardless of later writes.
+   *
+   *  @return A pointer to the current value.
+   */
+  pointer get() const {
+    detail::hazard_record &hazard = detail::thread_hazard();
+    pointer result = protect(hazard)->value;
+    hazard.pointer.store(nullptr, std::memory_order_release);
+    return result;
+  }
+
+  /**
+   *  @brief Reads the current value without taking a snapshot.
+   *  @details The function is called with a constant reference to the
+   * current value, which is only valid during the call. The function should
+   * not read any shared value property itself.
+   *
+   *  @tparam F The type of the function.
+   *  @param func The function to call.
+   *  @return The result of the function.
+   */
+  template <typename F> decltype(auto) read(F &&func) const {
+    struct clear {
+      detail::hazard_record &hazard;
+      ~clear() { hazard.pointer.store(nullptr, std::memory_order_release); }
+    } guard{detail::thread_hazard()};
+    return std::forward<F>(func)(*protect(guard.hazard)->value);
+  }
+
+  /**
+   *  @brief Publishes a new instance, then triggers the event.
+   *
+   *  @param value The new instance.
+   */
+  void set(pointer value) {
+    holder *old = current.exchange(new holder{value});
+    retire(old);
+    _set.trigger(value);
+  }
+  /**
+   *  @brief Publishes a copy of a value, then triggers the event.
+   *
+   *  @param value The new value.
+   */
+  void set(T value) { set(std::make_shared<const T>(std::move(value))); }
+
+  /**
+   *  @brief Adds a callback to the event.
+   *  @details The callback is passed through to the event's `operator +`.
+   * Whenever a new instance is published, the callback will be called with a
+   * pointer to it.
+   *
+   * @param callback The callback to add to the event.
+   */
+  void operator+(typename event<const pointer &>::Callable callback) {
+    _set + callback;
+  }
+
+  /**
+   *  @brief Destroys the property.
+   *  @details No thread may be reading the property anymore.
+   */
+  ~shared_value_property() {
+    delete current.load();
+    for (holder *h : retired)
+      delete h;
+  }
+
+private:
+  struct holder {
+    pointer value;
+  };
+
+  static constexpr std::size_t scan_threshold = 16;
+
+  holder *protect(detail::hazard_record &hazard) const {
+    holder *h = current.load();
+    for (;;) {
+      hazard.pointer.store(h);
+      holder *again = current.load();
+      if (again == h)
+        return h;
+      h = again;
+    }
+  }
+
+  void retire(holder *old) {
+    std::lock_guard<std::mutex> lock(retire_mutex);
+    retired.push_back(old);
+    if (retired.size() < scan_threshold)
+      return;
+    auto in_use = detail::hazards().protected_pointers();
+    auto keep = std::partition(retired.begin(), retired.end(), [&](holder *h) {
+      return std::binary_search(in_use.begin(), in_use.end(),
+                                static_cast<const void *>(h));
+    });
+    for (auto it = keep; it != retired.end(); ++it)
+      delete *it;
+    retired.erase(keep, retired.end());
+  }
+
+  std::atomic<holder *> current;
+  std::mutex retire_mutex;
+  std::vector<holder *> retired;
+  event<const pointer &> _set;
+};
+} // namespace properties
+
+#endif /* _PROP_SHARED_VALUE */
@@ -0,0 +1,72 @@
+#ifndef _PROP_THREAD_INDEX
+#define _PROP_THREAD_INDEX
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ * @brief Implementation details; not part of the public interface.
+ */
+namespace detail {
+/**
+ *  @brief Allocator for dense thread indices.
+ *  @details Each thread gets the smallest free index on first use, and hands
+ * it back when it exits, so indices stay small even when threads come and go.
+ */
+struct thread_indices {
+public:
+  /**
+   *  @brief Claims the smallest free index.
+   *  @return The index.
+   */
+  std::size_t acquire() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (free.empty())
+      return next++;
+    auto smallest = std::min_element(free.begin(), free.end());
+    std::size_t index = *smallest;
+    free.erase(smallest);
+    return index;
+  }
+
+  /**
+   *  @brief Hands an index back.
+   *
+   *  @param index The index to release.
+   */
+  void release(std::size_t index) {
+    std::lock_guard<std::mutex> lock(mutex);
+    free.push_back(index);
+  }
+
+private:
+  std::mutex mutex;
+  std::vector<std::size_t> free;
+  std::size_t next = 0;
+};
+
+/**
+ *  @brief Gets the index of the calling thread.
+ *  @details No two live threads share an index.
+ *
+ *  @return The index.
+ */
+inline std::size_t thread_index() {
+  static thread_indices indices;
+  struct owner {
+    std::size_t index = indices.acquire();
+    ~owner() { indices.release(index); }
+  };
+  thread_local owner current;
+  return current.index;
+}
+} // namespace detail
+} // namespace properties
+
+#endif /* _PROP_THREAD_INDEX */
@@ -0,0 +1,208 @@
+#ifndef _PROP_THREAD_LOCAL
+#define _PROP_THREAD_LOCAL
+
+#include "event.hpp"
+#include "thread_index.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ *  @brief Thread-local property.
+ *  @details This type holds one value per thread, each in its own cache line.
+ * A thread reads and writes its own value without any synchronization or
+ * contention (`local()`, `set_local()`, `update_local()`); those writes don't
+ * trigger the event. `get()` combines the values of the threads that used the
+ * property with the reducer, and `set()` broadcasts a value to all threads
+ * before triggering the event once.
+ *
+ * Slots start out with the initial value (or the last broadcast value). A
+ * slot keeps its value after its thread exits, and is reused by later
+ * threads. At most `max_threads` threads can use a property at the same
+ * time.
+ *
+ *  @tparam T The type of the value; it should be trivially copyable.
+ *  @tparam Reduce The type of the reducer, a callable of signature
+ * `T(const T &, const T &)`.
+ */
+template <typename T, typename Reduce = std::plus<T>>
+struct thread_local_property {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "thread_local_property: T should be trivially copyable");
+
+public:
+  /**
+   *  @brief The maximum amount of concurrently using threads.
+   */
+  static constexpr std::size_t max_threads = 4096;
+
+  /**
+   *  @brief Creates a new thread-local property.
+   *
+   *  @param initial The initial value of each thread's slot.
+   *  @param reduce The reducer combining the slots in `get()`.
+   */
+  explicit thread_local_property(T initial, Reduce reduce = Reduce{})
+      : initial{initial}, reduce{std::move(reduce)} {}
+
+  /**
+   *  @brief You can't copy a thread-local property.
+   */
+  thread_local_property(const thread_local_property &) = delete;
+
+  /**
+   *  @brief Gets the value of the calling thread.
+   *  @return The value.
+   */
+  T local() const {
+    return slot_for(detail::thread_index()).load(std::memory_order_relaxed);
+  }
+  /**
+   *  @brief Sets the value of the calling thread.
+   *  @details This does not trigger the event.
+   *
+   *  @param value The new value.
+   */
+  void set_local(T value) {
+    slot_for(detail::thread_index()).store(value, std::memory_order_relaxed);
+  }
+  /**
+   *  @brief Updates the value of the calling thread.
+   *  @details This does not trigger the event.
+   *
+   *  @tparam F The type of the update function.
+   *  @param func The function mapping the old value to the new one.
+   */
+  template <typename F> void update_local(F &&func) {
+    auto &slot = slot_for(detail::thread_index());
+    slot.store(func(slot.load(std::memory_order_relaxed)),
+               std::memory_order_relaxed);
+  }
+
+  /**
+   *  @brief Gets the combined value of all threads.
+   *  @details Only slots that were used are combined; if there are none, this
+   * is the initial (or last broadcast) value. After broadcasting `v`, this is
+   * the reducer applied over `v` once per used slot (e.g. `n * v` with
+   * `std::plus`). Values written by other threads concurrently may or may not
+   * be included.
+   *
+   *  @return The reduction of the used slots.
+   */
+  T get() const {
+    T result = initial_value();
+    bool first = true;
+    for (const auto &chunk : chunks) {
+      slot_chunk *c = chunk.load(std::memory_order_acquire);
+      if (c == nullptr)
+        continue;
+      for (const auto &s : c->slots) {
+        if (!s.claimed.load(std::memory_order_acquire))
+          continue;
+        T value = s.value.load(std::memory_order_relaxed);
+        result = first ? value : reduce(result, value);
+        first = false;
+      }
+    }
+    return result;
+  }
+
+  /**
+   *  @brief Sets the value of all threads, then triggers the event.
+   *  @details Every slot, used or not, gets the value, and so do slots created
+   * later. Local updates racing with the broadcast may be overwritten.
+   *
+   *  @param value The new value.
+   */
+  void set(T value) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      initial = value;
+      for (auto &chunk : chunks)
+        if (slot_chunk *c = chunk.load(std::memory_order_relaxed))
+          for (auto &s : c->slots)
+            s.value.store(value, std::memory_order_relaxed);
+    }
+    _set.trigger(value);
+  }
+
+  /**
+   *  @brief Adds a callback to the event.
+   *  @details The callback is passed through to the event's `operator +`.
+   * Whenever a value is broadcast, the callback will be called once with that
+   * value.
+   *
+   * @param callback The callback to add to the event.
+   */
+  void operator+(typename event<const T &>::Callable callback) {
+    _set + callback;
+  }
+
+  /**
+   *  @brief Destroys the property.
+   */
+  ~thread_local_property() {
+    for (auto &chunk : chunks)
+      delete chunk.load();
+  }
+
+private:
+  static constexpr std::size_t chunk_size = 64;
+
+  struct alignas(64) slot {
+    std::atomic<T> value;
+    std::atomic<bool> claimed{false};
+  };
+
+  struct slot_chunk {
+    explicit slot_chunk(T value) {
+      for (auto &s : slots)
+        s.value.store(value, std::memory_order_relaxed);
+    }
+    slot slots[chunk_size];
+  };
+
+  T initial_value() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return initial;
+  }
+
+  std::atomic<T> &slot_for(std::size_t index) const {
+    assert(index < max_threads);
+    auto &chunk = chunks[index / chunk_size];
+    slot_chunk *c = chunk.load(std::memory_order_acquire);
+    if (c == nullptr) {
+      std::lock_guard<std::mutex> lock(mutex);
+      c = chunk.load(std::memory_order_relaxed);
+      if (c == nullptr) {
+        c = new slot_chunk(initial);
+        chunk.store(c, std::memory_order_release);
+      }
+    }
+    slot &s = c->slots[index % chunk_size];
+    // only the owning thread claims its slot; claims are never undone
+    if (!s.claimed.load(std::memory_order_relaxed))
+      s.claimed.store(true, std::memory_order_release);
+    return s.value;
+  }
+
+  mutable std::mutex mutex;
+  T initial;
+  Reduce reduce;
+  mutable std::atomic<slot_chunk *> chunks[max_threads / chunk_size] = {};
+  event<const T &> _set;
+};
+} // namespace properties
+
+#endif /* _PROP_THREAD_LOCAL */
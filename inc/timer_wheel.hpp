@@ -0,0 +1,438 @@
+#ifndef _PROP_TIMER_WHEEL
+#define _PROP_TIMER_WHEEL
+
+#include "event.hpp"
+#include "property.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+/**
+ *  @brief Identifies a scheduled timer, to cancel it.
+ */
+struct timer_id {
+  /** @brief The slot of the timer. */
+  std::uint32_t index = std::numeric_limits<std::uint32_t>::max();
+  /** @brief The generation of the slot, so stale ids don't match. */
+  std::uint32_t generation = 0;
+};
+
+/**
+ *  @brief Hierarchical timing wheel for scheduled tasks, property writes and
+ * event triggers.
+ *  @details Time is split in ticks of a fixed resolution. Four levels of 256
+ * slots cover 2^8, 2^16, 2^24 and 2^32 ticks (at 1ms: 0.25s, 65s, 4.6h and
+ * 49 days); a timer goes into the lowest level that reaches its deadline,
+ * and moves down a level each time its slot comes up, until it expires.
+ * Timers further away than the top level wait there and are re-inserted
+ * until they are in range. Inserting and cancelling a timer take constant
+ * time, whatever the amount of timers.
+ *
+ * The wheel doesn't run by itself: call `advance()` (e.g. from an event
+ * loop), or let a `timer_thread` do it. Expired tasks run on the advancing
+ * thread, outside the lock, in deadline order (at tick resolution); they may
+ * schedule and cancel other timers. Tasks must not throw. The wheel is
+ * thread-safe.
+ *
+ * Scheduled property writes and event triggers go through the normal
+ * notification path, on the advancing thread. The targets must outlive the
+ * timers, or the timers must be cancelled first.
+ */
+struct timer_wheel {
+public:
+  /** @brief The clock of the deadlines. */
+  using clock = std::chrono::steady_clock;
+
+  /**
+   *  @brief Creates an empty wheel.
+   *
+   *  @param resolution The length of a tick (at least 1ns).
+   *  @param start The time of tick 0.
+   */
+  explicit timer_wheel(
+      std::chrono::nanoseconds resolution = std::chrono::milliseconds(1),
+      clock::time_point start = clock::now())
+      : resolution{std::max<std::chrono::nanoseconds::rep>(
+            1, resolution.count())},
+        start{start} {
+    heads.fill(none);
+    tails.fill(none);
+  }
+  /**
+   *  @brief You can't copy a wheel.
+   */
+  timer_wheel(const timer_wheel &) = delete;
+
+  /**
+   *  @brief Schedules a task at a deadline.
+   *  @details The deadline is rounded up to a tick, so the task never runs
+   * before it. A deadline in the past expires at the next tick.
+   *
+   *  @param deadline When to run the task.
+   *  @param task The task.
+   *  @return The id of the timer.
+   */
+  timer_id schedule_at(clock::time_point deadline,
+                       std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::uint32_t i = allocate();
+    timer &t = timers[i];
+    t.task = std::move(task);
+    t.expires = std::max(tick_after(deadline), current + 1);
+    insert(i);
+    return {i, t.generation};
+  }
+
+  /**
+   *  @brief Schedules a task after a delay.
+   *
+   *  @param delay How long to wait from now.
+   *  @param task The task.
+   *  @return The id of the timer.
+   */
+  timer_id schedule_after(clock::duration delay, std::function<void()> task) {
+    return schedule_at(clock::now() + delay, std::move(task));
+  }
+
+  /**
+   *  @brief Sets a property at a deadline.
+   *
+   *  @tparam T The type of the value.
+   *  @tparam copy The copy state of the property.
+   *  @param target The property.
+   *  @param deadline When to set it.
+   *  @param value The new value.
+   *  @return The id of the timer.
+   */
+  template <typename T, bool copy>
+  timer_id set_at(property<T, copy> &target, clock::time_point deadline,
+                  T value) {
+    return schedule_at(deadline, [&target, value = std::move(value)]() {
+      target.set(value);
+    });
+  }
+
+  /**
+   *  @brief Sets a property after a delay.
+   *
+   *  @tparam T The type of the value.
+   *  @tparam copy The copy state of the property.
+   *  @param target The property.
+   *  @param delay How long to wait from now.
+   *  @param value The new value.
+   *  @return The id of the timer.
+   */
+  template <typename T, bool copy>
+  timer_id set_after(property<T, copy> &target, clock::duration delay,
+                     T value) {
+    return set_at(target, clock::now() + delay, std::move(value));
+  }
+
+  /**
+   *  @brief Triggers an event at a deadline.
+   *  @details The value is copied into the timer; reference events get a
+   * reference to that copy.
+   *
+   *  @tparam Out The type of the event.
+   *  @param target The event.
+   *  @param deadline When to trigger it.
+   *  @param value The value to trigger it with.
+   *  @return The id of the timer.
+   */
+  template <typename Out>
+  timer_id trigger_at(event<Out> &target, clock::time_point deadline,
+                      typename std::decay<Out>::type value) {
+    return schedule_at(deadline,
+                       [&target, value = std::move(value)]() mutable {
+                         target.trigger(value);
+                       });
+  }
+
+  /**
+   *  @brief Triggers an event after a delay.
+   *
+   *  @tparam Out The type of the event.
+   *  @param target The event.
+   *  @param delay How long to wait from now.
+   *  @param value The value to trigger it with.
+   *  @return The id of the timer.
+   */
+  template <typename Out>
+  timer_id trigger_after(event<Out> &target, clock::duration delay,
+                         typename std::decay<Out>::type value) {
+    return trigger_at(target, clock::now() + delay, std::move(value));
+  }
+
+  /**
+   *  @brief Cancels a timer.
+   *
+   *  @param id The id of the timer.
+   *  @return True if the timer was pending, false if it already expired or
+   * was cancelled.
+   */
+  bool cancel(timer_id id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (id.index >= timers.size())
+      return false;
+    timer &t = timers[id.index];
+    if (t.generation != id.generation || t.slot == none)
+      return false;
+    unlink(id.index);
+    release(id.index);
+    return true;
+  }
+
+  /**
+   *  @brief Runs every task whose deadline has passed.
+   *
+   *  @param now The current time.
+   *  @return The amount of tasks run.
+   */
+  std::size_t advance(clock::time_point now = clock::now()) {
+    std::vector<std::function<void()>> expired;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      std::uint64_t target = tick_of(now);
+      while (current < target) {
+        if (pending == 0) {
+          current = target;
+          break;
+        }
+        // nothing on level 0: skip to the end of its rotation
+        if (counts[0] == 0)
+          current = std::min(target - 1, current | (slots - 1));
+        current++;
+        cascade();
+        std::size_t slot = current & (slots - 1);
+        while (heads[slot] != none) {
+          std::uint32_t i = heads[slot];
+          unlink(i);
+          expired.push_back(std::move(timers[i].task));
+          release(i);
+        }
+      }
+    }
+    for (auto &task : expired)
+      task();
+    return expired.size();
+  }
+
+  /**
+   *  @brief Gets the time the next tick starts, for drivers.
+   *  @return The start of the next tick.
+   */
+  clock::time_point next_tick() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return start + std::chrono::nanoseconds(resolution * (current + 1));
+  }
+
+  /**
+   *  @brief Gets the amount of pending timers.
+   *  @return The amount of timers.
+   */
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending;
+  }
+
+  /**
+   *  @brief Destroys the wheel; pending timers never run.
+   */
+  ~timer_wheel() = default;
+
+private:
+  static constexpr std::uint32_t none =
+      std::numeric_limits<std::uint32_t>::max();
+  static constexpr std::size_t levels = 4;
+  static constexpr std::size_t bits = 8;
+  static constexpr std::uint64_t slots = 1 << bits;
+
+  struct timer {
+    std::function<void()> task;
+    std::uint64_t expires = 0;
+    std::uint32_t prev = none;
+    std::uint32_t next = none;
+    std::uint32_t slot = none;
+    std::uint32_t generation = 0;
+  };
+
+  // the last tick that started at or before the time
+  std::uint64_t tick_of(clock::time_point time) const {
+    if (time <= start)
+      return 0;
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time -
+                                                                   start);
+    return static_cast<std::uint64_t>(ns.count() / resolution);
+  }
+
+  // the first tick that starts at or after the time
+  std::uint64_t tick_after(clock::time_point time) const {
+    if (time <= start)
+      return 0;
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time -
+                                                                   start);
+    return static_cast<std::uint64_t>((ns.count() + resolution - 1) /
+                                      resolution);
+  }
+
+  std::uint32_t allocate() {
+    pending++;
+    if (free_list != none) {
+      std::uint32_t i = free_list;
+      free_list = timers[i].next;
+      timers[i].next = none;
+      return i;
+    }
+    timers.emplace_back();
+    return static_cast<std::uint32_t>(timers.size() - 1);
+  }
+
+  void release(std::uint32_t i) {
+    timer &t = timers[i];
+    t.task = nullptr;
+    t.generation++;
+    t.next = free_list;
+    free_list = i;
+    pending--;
+  }
+
+  // puts a timer in the lowest level that reaches its deadline
+  void insert(std::uint32_t i) {
+    timer &t = timers[i];
+    std::uint64_t expires = std::max(t.expires, current);
+    std::uint64_t delta = expires - current;
+    std::size_t level = 0;
+    while (level + 1 < levels && delta >> (bits * (level + 1)) != 0)
+      level++;
+    // too far for the top level: park it as far as possible, and re-insert it
+    // when that slot comes up
+    if (delta >> (bits * levels) != 0)
+      expires = current + (std::uint64_t{1} << (bits * levels)) - 1;
+    std::size_t slot =
+        level * slots + ((expires >> (bits * level)) & (slots - 1));
+
+    t.slot = static_cast<std::uint32_t>(slot);
+    t.prev = tails[slot];
+    t.next = none;
+    if (tails[slot] == none)
+      heads[slot] = i;
+    else
+      timers[tails[slot]].next = i;
+    tails[slot] = i;
+    counts[level]++;
+  }
+
+  void unlink(std::uint32_t i) {
+    timer &t = timers[i];
+    if (t.prev == none)
+      heads[t.slot] = t.next;
+    else
+      timers[t.prev].next = t.next;
+    if (t.next == none)
+      tails[t.slot] = t.prev;
+    else
+      timers[t.next].prev = t.prev;
+    counts[t.slot / slots]--;
+    t.prev = none;
+    t.next = none;
+    t.slot = none;
+  }
+
+  // at the start of a rotation of a level, moves the timers of the current
+  // slot of the level above down (highest level first)
+  void cascade() {
+    std::size_t top = 0;
+    while (top + 1 < levels &&
+           (current & ((std::uint64_t{1} << (bits * (top + 1))) - 1)) == 0)
+      top++;
+    for (std::size_t level = top; level >= 1; level--) {
+      std::size_t slot =
+          level * slots + ((current >> (bits * level)) & (slots - 1));
+      std::uint32_t i = heads[slot];
+      while (i != none) {
+        std::uint32_t next = timers[i].next;
+        unlink(i);
+        insert(i);
+        i = next;
+      }
+    }
+  }
+
+  std::int64_t resolution;
+  clock::time_point start;
+  mutable std::mutex mutex;
+  std::vector<timer> timers;
+  std::array<std::uint32_t, levels * slots> heads;
+  std::array<std::uint32_t, levels * slots> tails;
+  std::array<std::size_t, levels> counts{};
+  std::uint32_t free_list = none;
+  std::uint64_t current = 0;
+  std::size_t pending = 0;
+};
+
+/**
+ *  @brief Thread advancing a timing wheel once per tick.
+ *  @details Scheduled tasks, property writes and event triggers run on this
+ * thread.
+ */
+struct timer_thread {
+public:
+  /**
+   *  @brief Starts advancing the wheel.
+   *
+   *  @param wheel The wheel; it must outlive the thread.
+   */
+  explicit timer_thread(timer_wheel &wheel)
+      : worker{[this, &wheel]() { run(wheel); }} {}
+  /**
+   *  @brief You can't copy a timer thread.
+   */
+  timer_thread(const timer_thread &) = delete;
+
+  /**
+   *  @brief Stops and joins the thread; pending timers stay in the wheel.
+   */
+  ~timer_thread() {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      stop = true;
+    }
+    wake.notify_one();
+    worker.join();
+  }
+
+private:
+  void run(timer_wheel &wheel) {
+    std::unique_lock<std::mutex> guard(lock);
+    while (!stop) {
+      guard.unlock();
+      wheel.advance();
+      auto next = wheel.next_tick();
+      guard.lock();
+      wake.wait_until(guard, next, [this]() { return stop; });
+    }
+  }
+
+  std::mutex lock;
+  std::condition_variable wake;
+  bool stop = false;
+  std::thread worker;
+};
+} // namespace properties
+
+#endif /* _PROP_TIMER_WHEEL */
@@ -0,0 +1,393 @@
+#ifndef _PROP_TRANSACTION
+#define _PROP_TRANSACTION
+
+#include "event.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Main namespace for the properties library.
+ */
+namespace properties {
+template <typename T> struct tx_property;
+struct transaction;
+struct read_transaction;
+
+/**
+ *  @brief Transaction domain.
+ *  @details A domain groups the transactional properties that can be updated
+ * together. It keeps the commit clock (the version of the last commit) and
+ * the versions that running read transactions are looking at, so old values
+ * are only reclaimed once no reader can see them anymore. Commits within a
+ * domain are serialized; reads never take a lock.
+ */
+struct tx_domain {
+public:
+  /**
+   *  @brief Creates a new domain.
+   */
+  tx_domain() = default;
+  /**
+   *  @brief You can't copy a domain.
+   */
+  tx_domain(const tx_domain &) = delete;
+
+  /**
+   *  @brief Gets the version of the last commit.
+   *  @return The current version.
+   */
+  std::uint64_t version() const { return clock.load(); }
+
+  /**
+   *  @brief Destroys the domain.
+   *  @details All properties and transactions of the domain should be
+   * destroyed first.
+   */
+  ~tx_domain() {
+    for (slot *s = slots.load(); s != nullptr;) {
+      slot *next = s->next;
+      delete s;
+      s = next;
+    }
+  }
+
+private:
+  friend struct transaction;
+  friend struct read_transaction;
+  template <typename T> friend struct tx_property;
+
+  static constexpr std::uint64_t idle =
+      std::numeric_limits<std::uint64_t>::max();
+
+  struct alignas(64) slot {
+    std::atomic<std::uint64_t> version{idle};
+    std::atomic<bool> active{false};
+    slot *next = nullptr;
+  };
+
+  slot *acquire() {
+    for (slot *s = slots.load(); s != nullptr; s = s->next) {
+      bool expected = false;
+      if (!s->active.load(std::memory_order_relaxed) &&
+          s->active.compare_exchange_strong(expected, true))
+        return s;
+    }
+    auto *s = new slot;
+    s->active.store(true, std::memory_order_relaxed);
+    s->next = slots.load();
+    while (!slots.compare_exchange_weak(s->next, s)) {
+    }
+    return s;
+  }
+
+  void release(slot *s) {
+    s->version.store(idle);
+    s->active.store(false);
+  }
+
+  // Registers a reader at the current version; retries while a commit is
+  // published concurrently, so a pruning commit always sees the registration.
+  std::uint64_t enter(slot *s) {
+    std::uint64_t version = clock.load();
+    for (;;) {
+      s->version.store(version);
+      std::uint64_t again = clock.load();
+      if (again == version)
+        return version;
+      version = again;
+    }
+  }
+
+  std::uint64_t oldest_reader() const {
+    std::uint64_t oldest = clock.load();
+    for (slot *s = slots.load(); s != nullptr; s = s->next)
+      oldest = std::min(oldest, s->version.load());
+    return oldest;
+  }
+
+  std::atomic<std::uint64_t> clock{0};
+  std::atomic<slot *> slots{nullptr};
+  std::mutex commit_mutex;
+};
+
+/**
+ *  @brief Read transaction.
+ *  @details A read transaction sees a consistent snapshot of all properties in
+ * its domain: the values of the last commit before the transaction started.
+ * Commits made while the transaction is running are not visible to it, and
+ * the transaction never blocks them.
+ */
+struct read_transaction {
+public:
+  /**
+   *  @brief Starts a read transaction.
+   *
+   *  @param domain The domain to read from.
+   */
+  explicit read_transaction(tx_domain &domain)
+      : domain{domain}, reader{domain.acquire()},
+        at{domain.enter(reader)} {}
+
+  /**
+   *  @brief You can't copy a read transaction.
+   */
+  read_transaction(const read_transaction &) = delete;
+
+  /**
+   *  @brief Reads a property.
+   *  @details The property should belong to the domain of this transaction.
+   *
+   *  @tparam T The type of the value.
+   *  @param prop The property to read.
+   *  @return A constant reference to the value, which is valid until the end
+   * of the transaction.
+   */
+  template <typename T> const T &get(const tx_property<T> &prop) const {
+    assert(&prop.domain == &domain);
+    return prop.at(at);
+  }
+
+  /**
+   *  @brief Gets the version this transaction reads.
+   *  @return The version.
+   */
+  std::uint64_t version() const { return at; }
+
+  /**
+   *  @brief Ends the read transaction.
+   */
+  ~read_transaction() { domain.release(reader); }
+
+private:
+  tx_domain &domain;
+  tx_domain::slot *reader;
+  std::uint64_t at;
+};
+
+/**
+ *  @brief Write transaction.
+ *  @details A write transaction stages writes to any amount of properties in
+ * its domain. Nothing is visible until `commit()`, which installs all writes
+ * under a single new version: readers see either all of them or none. After
+ * the commit, the event of each written property is triggered once. Destroying
+ * an uncommitted transaction discards its writes.
+ */
+struct transaction {
+public:
+  /**
+   *  @brief Starts a write transaction.
+   *
+   *  @param domain The domain to write to.
+   */
+  explicit transaction(tx_domain &domain) : domain{domain} {}
+
+  /**
+   *  @brief You can't copy a write transaction.
+   */
+  transaction(const transaction &) = delete;
+
+  /**
+   *  @brief Stages a write.
+   *  @details Writing the same property twice keeps the last value. The
+   * property should belong to the domain of this transaction.
+   *
+   *  @tparam T The type of the value.
+   *  @param prop The property to write.
+   *  @param value The new value.
+   */
+  template <typename T> void set(tx_property<T> &prop, T value) {
+    assert(&prop.domain == &domain);
+    for (auto &staged : writes) {
+      if (staged->target() == &prop) {
+        static_cast<write<T> &>(*staged).value = std::move(value);
+        return;
+      }
+    }
+    writes.push_back(std::make_unique<write<T>>(prop, std::move(value)));
+  }
+
+  /**
+   *  @brief Commits the staged writes.
+   *  @details After the new version is published, the event of each written
+   * property is triggered with its new value. The transaction is empty
+   * afterwards.
+   *
+   *  @return The version of the commit.
+   */
+  std::uint64_t commit() {
+    tx_domain::slot *reader = domain.acquire();
+    std::uint64_t version;
+    {
+      std::lock_guard<std::mutex> lock(domain.commit_mutex);
+      version = domain.clock.load() + 1;
+      for (auto &staged : writes)
+        staged->install(version);
+      domain.clock.store(version);
+      reader->version.store(version);
+      std::uint64_t oldest = domain.oldest_reader();
+      for (auto &staged : writes)
+        staged->prune(oldest);
+    }
+    for (auto &staged : writes)
+      staged->notify(version);
+    domain.release(reader);
+    writes.clear();
+    return version;
+  }
+
+  /**
+   *  @brief Destroys the transaction, discarding uncommitted writes.
+   */
+  ~transaction() = default;
+
+private:
+  struct staged_write {
+    virtual ~staged_write() = default;
+    virtual const void *target() const = 0;
+    virtual void install(std::uint64_t version) = 0;
+    virtual void prune(std::uint64_t oldest) = 0;
+    virtual void notify(std::uint64_t version) = 0;
+  };
+
+  template <typename T> struct write : staged_write {
+    write(tx_property<T> &prop, T value)
+        : prop{prop}, value{std::move(value)} {}
+    const void *target() const override { return &prop; }
+    void install(std::uint64_t version) override {
+      prop.install(version, std::move(value));
+    }
+    void prune(std::uint64_t oldest) override { prop.prune(oldest); }
+    void notify(std::uint64_t version) override {
+      prop._set.trigger(prop.at(version));
+    }
+
+    tx_property<T> &prop;
+    T value;
+  };
+
+  tx_domain &domain;
+  std::vector<std::unique_ptr<staged_write>> writes;
+};
+
+/**
+ *  @brief Transactional property.
+ *  @details This type holds a chain of versions of its value; readers pick
+ * the newest version that is not newer than their snapshot. Writes go through
+ * a `transaction`, so several properties of the same domain can be updated
+ * atomically. Versions no running reader can see anymore are reclaimed on
+ * commit. Callbacks should be added before the property is shared between
+ * threads.
+ *
+ *  @tparam T The type of the value.
+ */
+template <typename T> struct tx_property {
+public:
+  /**
+   *  @brief Creates a new transactional property.
+   *
+   *  @param domain The domain of the property.
+   *  @param value The initial value.
+   */
+  tx_property(tx_domain &domain, T value)
+      : domain{domain}, head{new node{0, std::move(value), nullptr}} {}
+
+  /**
+   *  @brief You can't copy a transactional property.
+   */
+  tx_property(const tx_property &) = delete;
+
+  /**
+   *  @brief Gets the value of the last commit.
+   *  @return A copy of the value.
+   */
+  T get() const {
+    read_transaction tx(domain);
+    return tx.get(*this);
+  }
+
+  /**
+   *  @brief Sets the value in a transaction of its own, then triggers the
+   * event.
+   *
+   *  @param value The new value.
+   */
+  void set(T value) {
+    transaction tx(domain);
+    tx.set(*this, std::move(value));
+    tx.commit();
+  }
+
+  /**
+   *  @brief Adds a callback to the event.
+   *  @details The callback is passed through to the event's `operator +`.
+   * After each commit writing this property, the callback will be called once
+   * with a constant reference to the new value.
+   *
+   * @param callback The callback to add to the event.
+   */
+  void operator+(typename event<const T &>::Callable callback) {
+    _set + callback;
+  }
+
+  /**
+   *  @brief Destroys the property.
+   *  @details No transaction may be using the property anymore.
+   */
+  ~tx_property() {
+    for (node *n = head.load(); n != nullptr;) {
+      node *older = n->older;
+      delete n;
+      n = older;
+    }
+  }
+
+private:
+  friend struct transaction;
+  friend struct read_transaction;
+
+  struct node {
+    std::uint64_t version;
+    T value;
+    node *older;
+  };
+
+  const T &at(std::uint64_t version) const {
+    node *n = head.load(std::memory_order_acquire);
+    while (n->version > version)
+      n = n->older;
+    return n->value;
+  }
+
+  void install(std::uint64_t version, T value) {
+    head.store(new node{version, std::move(value), head.load()},
+               std::memory_order_release);
+  }
+
+  void prune(std::uint64_t oldest) {
+    node *n = head.load();
+    while (n->version > oldest)
+      n = n->older;
+    node *garbage = n->older;
+    n->older = nullptr;
+    while (garbage != nullptr) {
+      node *older = garbage->older;
+      delete garbage;
+      garbage = older;
+    }
+  }
+
+  tx_domain &domain;
+  std::atomic<node *> head;
+  event<const T &> _set;
+};
+} // namespace properties
+
+#endif /* _PROP_TRANSACTION */
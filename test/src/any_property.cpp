@@ -0,0 +1,53 @@
+#include "any_property.hpp"
+#include "property.hpp"
+#include "doctest/doctest.h"
+
+#include <string>
+#include <vector>
+
+using namespace properties;
+
+TEST_CASE("Any property is two pointers") {
+  CHECK_EQ(sizeof(any_property), 2 * sizeof(void *));
+}
+
+TEST_CASE("Any property bytes") {
+  int raw = 4;
+  property<int> a(raw);
+  property<std::string, true> b(std::string("hello"));
+  std::vector<any_property> all{a, b};
+
+  CHECK_EQ(all[1].get_bytes(), serialize(std::string("hello")));
+  CHECK(all[0].set_bytes(serialize(9)));
+  CHECK_EQ(raw, 9);
+  CHECK_FALSE(all[0].set_bytes("x"));
+  CHECK_EQ(raw, 9);
+
+  std::string out = "prefix";
+  all[0].get_bytes(out);
+  CHECK_EQ(out, "prefix" + serialize(9));
+}
+
+TEST_CASE("Any property types") {
+  property<double, true> d(1.5);
+  any_property handle(d);
+
+  CHECK(handle.holds<double>());
+  CHECK_FALSE(handle.holds<float>());
+  CHECK_EQ(handle.type(), type_of<double>());
+  CHECK((handle.as<double, true>() == &d));
+  CHECK((handle.as<double, false>() == nullptr));
+  CHECK((handle.as<int, true>() == nullptr));
+}
+
+TEST_CASE("Any property events") {
+  property<int, true> p(0);
+  any_property handle(p);
+  int calls = 0;
+
+  handle.subscribe([&calls]() { calls++; });
+  p = 3;
+  handle.set_bytes(serialize(4));
+  CHECK_EQ(calls, 2);
+  CHECK_EQ(p.get(), 4);
+}
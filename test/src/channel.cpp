@@ -0,0 +1,76 @@
+#include "channel.hpp"
+#include "property.hpp"
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace properties;
+
+TEST_CASE("Channel conflates values") {
+  conflating_channel<int> channel(-1);
+  int out = 0;
+
+  CHECK_FALSE(channel.take(out));
+  CHECK_EQ(channel.latest(), -1);
+
+  channel.publish(1);
+  channel.publish(2);
+  channel.publish(3);
+  CHECK(channel.take(out));
+  CHECK_EQ(out, 3);
+  CHECK_FALSE(channel.take(out));
+  CHECK_EQ(channel.latest(), 3);
+
+  channel.publish(4);
+  CHECK(channel.take());
+  CHECK_EQ(channel.latest(), 4);
+}
+
+TEST_CASE("Channel attached to a property") {
+  property<int, true> p(5);
+  conflating_channel<int> channel(p);
+  int wakeups = 0;
+  auto callback = [&wakeups](conflating_channel<int> &) { wakeups++; };
+  channel + callback;
+
+  CHECK_EQ(channel.latest(), 5);
+  p = 6;
+  p.set(7);
+  CHECK_EQ(wakeups, 2);
+  CHECK(channel.take());
+  CHECK_EQ(channel.latest(), 7);
+}
+
+TEST_CASE("Channel between threads") {
+  struct pair {
+    int a;
+    int b;
+  };
+  conflating_channel<pair> channel(pair{0, 0});
+  std::atomic<bool> done{false};
+  int errors = 0;
+  int last = 0;
+
+  std::thread consumer([&]() {
+    pair out{0, 0};
+    for (;;) {
+      bool finished = done.load();
+      if (channel.take(out)) {
+        if (out.a != out.b || out.a < last)
+          errors++;
+        last = out.a;
+      } else if (finished) {
+        break;
+      }
+    }
+  });
+
+  for (int i = 1; i <= 100000; i++)
+    channel.publish(pair{i, i});
+  done = true;
+  consumer.join();
+
+  CHECK_EQ(errors, 0);
+  CHECK_EQ(last, 100000);
+}
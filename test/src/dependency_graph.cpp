@@ -0,0 +1,106 @@
+#include "dependency_graph.hpp"
+#include "expression.hpp"
+#include "property.hpp"
+#include "doctest/doctest.h"
+
+#include <chrono>
+#include <string>
+
+using namespace properties;
+
+namespace {
+void spin(std::chrono::microseconds duration) {
+  auto end = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < end)
+    ;
+}
+} // namespace
+
+TEST_CASE("Dependency graph records edges and the critical path") {
+  property<int, true> a(0);
+  property<int, true> b(0);
+  property<int, true> c(0);
+  property<int, true> d(0);
+  a + [&b](int &v) { b.set(v + 1); };
+  a + [&d](int &v) { d.set(v + 1); };
+  b + [&c](int &v) { c.set(v + 1); };
+  c + [](int &) { spin(std::chrono::microseconds(200)); };
+
+  dependency_graph graph;
+  CHECK_EQ(graph.track("a", a), 0);
+  CHECK_EQ(graph.track("b", b), 1);
+  CHECK_EQ(graph.track("c", c), 2);
+  CHECK_EQ(graph.track("d", d), 3);
+
+  a.set(1);
+  a.set(2);
+  CHECK_EQ(c.get(), 4);
+
+  auto s = graph.collect();
+  REQUIRE_EQ(s.nodes.size(), 4);
+  for (const auto &n : s.nodes)
+    CHECK_EQ(n.triggers, 2);
+  REQUIRE_EQ(s.edges.size(), 3);
+  CHECK_EQ(s.edges[0].from, 0);
+  CHECK_EQ(s.edges[0].to, 1);
+  CHECK_EQ(s.edges[0].calls, 2);
+  CHECK_EQ(s.edges[1].to, 3);
+  CHECK_EQ(s.edges[2].from, 1);
+  CHECK_EQ(s.edges[2].to, 2);
+  CHECK_GE(s.edges[2].total_ns, 200e3);
+
+  REQUIRE_EQ(s.critical_path.size(), 3);
+  CHECK_EQ(s.critical_path[0].node, 0);
+  CHECK_EQ(s.critical_path[1].node, 1);
+  CHECK_EQ(s.critical_path[2].node, 2);
+  CHECK_GE(s.wave_ns, s.critical_path[2].total_ns);
+  CHECK_GE(s.critical_path[2].self_ns, 200e3);
+}
+
+TEST_CASE("Dependency graph skips untracked nodes") {
+  property<int, true> source(1);
+  property<int, true> middle(0);
+  computed doubled = middle * 2;
+  source + [&middle](int &v) { middle.set(v); };
+
+  dependency_graph graph;
+  graph.track("source", source);
+  graph.track("doubled", doubled);
+  source.set(3);
+  CHECK_EQ(doubled.get(), 6);
+
+  auto s = graph.collect();
+  REQUIRE_EQ(s.edges.size(), 1);
+  CHECK_EQ(s.edges[0].from, 0);
+  CHECK_EQ(s.edges[0].to, 1);
+}
+
+TEST_CASE("Dependency graph exports DOT and JSON") {
+  event<int> first;
+  event<int> second;
+  auto forward = [&second](int v) { second.trigger(v); };
+  first + forward;
+
+  dependency_graph graph;
+  graph.track("first \"event\"", first);
+  graph.track("second\tline\r\n\x01", second);
+  first.trigger(1);
+
+  std::string dot = graph.dot();
+  CHECK_NE(dot.find("digraph dependencies {"), std::string::npos);
+  CHECK_NE(dot.find("first \\\"event\\\""), std::string::npos);
+  CHECK_NE(dot.find("n0 -> n1 [label=\"1 calls"), std::string::npos);
+  CHECK_NE(dot.find("color=red"), std::string::npos);
+
+  std::string json = graph.json();
+  CHECK_NE(json.find("{\"id\":0,\"name\":\"first \\\"event\\\"\""),
+           std::string::npos);
+  CHECK_NE(json.find("{\"from\":0,\"to\":1,\"calls\":1,"), std::string::npos);
+  CHECK_NE(json.find("\"steps\":[{\"node\":0,"), std::string::npos);
+  CHECK_NE(json.find("\"name\":\"second\\tline\\r\\n\\u0001\""),
+           std::string::npos);
+  bool control = false;
+  for (char c : json)
+    control |= static_cast<unsigned char>(c) < 0x20 && c != '\n';
+  CHECK_FALSE(control);
+}
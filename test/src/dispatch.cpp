@@ -0,0 +1,89 @@
+#include "event.hpp"
+#include "property.hpp"
+#include "doctest/doctest.h"
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+
+using namespace properties;
+
+TEST_CASE("Type-erased listeners of every size") {
+  event<int> e;
+  int sum = 0;
+  std::array<int, 32> large{};
+  large[0] = 100;
+  auto small = [&sum](int v) { sum += v; };
+  auto spilled = [&sum, large](int v) { sum += v + large[0]; };
+  std::function<void(int)> wrapped = [&sum](int v) { sum += 2 * v; };
+  e + small;
+  e + spilled;
+  e + wrapped;
+
+  e.trigger(1);
+  CHECK_EQ(sum, 1 + 101 + 2);
+}
+
+TEST_CASE("Copied events copy the listener state") {
+  event<int> e;
+  int last = 0;
+  auto counter = [&last, calls = 0](int) mutable { last = ++calls; };
+  e + counter;
+  e.trigger(0);
+  e.trigger(0);
+
+  event<int> copy = e;
+  copy.trigger(0);
+  CHECK_EQ(last, 3);
+  e.trigger(0);
+  CHECK_EQ(last, 3);
+
+  event<int> moved = std::move(copy);
+  moved.trigger(0);
+  CHECK_EQ(last, 4);
+}
+
+TEST_CASE("Listeners by value get their own copy") {
+  event<std::string> e;
+  std::string seen;
+  auto append = [](std::string s) { s += "!"; };
+  auto consume = [&seen](std::string &&s) { seen = std::move(s); };
+  e + append;
+  e + consume;
+
+  e.trigger("value");
+  CHECK_EQ(seen, "value");
+}
+
+TEST_CASE("Events over non-copyable values stay synchronous") {
+  event<std::unique_ptr<int> &> e;
+  listener_pool pool(1);
+  listener_policy policy;
+  policy.budget = std::chrono::nanoseconds(0);
+  policy.strikes = 1;
+  policy.pool = &pool;
+  int seen = 0;
+  auto read = [&seen](std::unique_ptr<int> &p) { seen = *p; };
+  e + read;
+  e.monitor_listeners(policy);
+
+  auto value = std::make_unique<int>(4);
+  e.trigger(value);
+  e.trigger(value);
+  CHECK_EQ(seen, 4);
+  auto stats = e.listener_statistics();
+  REQUIRE_EQ(stats.size(), 1);
+  CHECK(stats[0].flagged);
+  CHECK_FALSE(stats[0].async);
+}
+
+TEST_CASE("Property forwards callables without wrapping them") {
+  property<int, true> p(0);
+  int sum = 0;
+  auto add = [&sum](int &v) { sum += v; };
+  p + add;
+  p + [&sum](const int &v) { sum += 10 * v; };
+  p.set(2);
+  CHECK_EQ(sum, 22);
+}
@@ -0,0 +1,54 @@
+#include "expression.hpp"
+#include "property.hpp"
+#include "doctest/doctest.h"
+
+using namespace properties;
+
+TEST_CASE("Computed expression") {
+  property<double, true> price(2.5);
+  int raw_qty = 4;
+  property<int> qty(raw_qty);
+  property<double, true> fee(1.0);
+
+  computed total = price * qty + fee;
+  CHECK_EQ(total.get(), 11.0);
+
+  qty = 2;
+  CHECK_EQ(total.get(), 6.0);
+  fee = 0.5;
+  CHECK_EQ(total.get(), 5.5);
+}
+
+TEST_CASE("Computed expression with constants") {
+  property<int, true> a(3);
+  property<int, true> b(7);
+
+  computed c = -(a - b) * 2 + b % a + 1;
+  CHECK_EQ(c.get(), 10);
+
+  b = 10;
+  CHECK_EQ(c.get(), 16);
+}
+
+TEST_CASE("Computed expression events") {
+  property<int, true> a(1);
+  int calls = 0;
+  auto callback = [&calls](const int &) { calls++; };
+
+  computed square = a * a;
+  square + callback;
+  computed plus = square + 1;
+
+  a = 5;
+  CHECK_EQ(calls, 1);
+  CHECK_EQ(square.get(), 25);
+  CHECK_EQ(plus.get(), 26);
+}
+
+TEST_CASE("Expressions convert to values") {
+  property<int, true> a(6);
+  property<int, true> b(7);
+
+  int product = a * b;
+  CHECK_EQ(product, 42);
+}
@@ -0,0 +1,140 @@
+#include "flight_recorder.hpp"
+#include "property.hpp"
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+using namespace properties;
+
+namespace {
+std::string flight_path(const char *name) {
+  return "/tmp/prop_flight_" + std::string(name) + "_" +
+         std::to_string(::getpid());
+}
+} // namespace
+
+TEST_CASE("Flight recorder writes decodable records") {
+  std::string path = flight_path("basic");
+  int i = 0;
+  property<int> speed(i);
+  property<double, true> ratio(0.5);
+  {
+    flight_recorder recorder(path, 4, 8);
+    REQUIRE(recorder.is_open());
+    CHECK_EQ(recorder.watch(speed, "speed"), 0);
+    CHECK_EQ(recorder.watch(ratio, "ratio"), 1);
+    speed.set(3);
+    ratio.set(0.25);
+    speed.set(4);
+  }
+
+  auto log = read_flight_log(path);
+  REQUIRE(log);
+  REQUIRE_EQ(log->names.size(), 2);
+  CHECK_EQ(log->names[0].text, "speed");
+  CHECK((log->names[0].value_kind == flight::kind::signed_integer));
+  CHECK((log->names[1].value_kind == flight::kind::floating_point));
+  REQUIRE_EQ(log->entries.size(), 3);
+  CHECK_EQ(log->entries[0].id, 0);
+  CHECK_EQ(log->entries[1].id, 1);
+  int value = 0;
+  std::memcpy(&value, log->entries[2].bytes, sizeof(int));
+  CHECK_EQ(value, 4);
+  CHECK_LE(log->entries[0].time, log->entries[2].time);
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Flight recorder keeps the most recent records") {
+  std::string path = flight_path("wrap");
+  flight_recorder recorder(path, 2, 5);
+  std::uint32_t id = recorder.declare<unsigned>("counter");
+  for (unsigned n = 0; n < 20; n++)
+    recorder.record(id, n);
+
+  auto log = read_flight_log(path);
+  REQUIRE(log);
+  REQUIRE_EQ(log->entries.size(), 8);
+  unsigned first = 0;
+  std::memcpy(&first, log->entries[0].bytes, sizeof(unsigned));
+  CHECK_EQ(first, 12);
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Flight recorder uses one ring per thread") {
+  std::string path = flight_path("threads");
+  flight_recorder recorder(path, 2, 16);
+  std::uint32_t id = recorder.declare<int>("value");
+  recorder.record(id, 1);
+  std::atomic<bool> release{false};
+  std::thread second([&]() {
+    recorder.record(id, 2);
+    while (!release)
+      std::this_thread::yield();
+  });
+  while (read_flight_log(path)->entries.size() < 2)
+    std::this_thread::yield();
+  std::atomic<bool> overflowed{false};
+  std::atomic<bool> exited{false};
+  std::thread third([&]() {
+    for (int n = 0; n < 3; n++)
+      recorder.record(id, 3);
+    overflowed = true;
+    // once the second thread exits, its ring is free again
+    while (!exited)
+      std::this_thread::yield();
+    recorder.record(id, 4);
+  });
+  while (!overflowed)
+    std::this_thread::yield();
+  release = true;
+  second.join();
+  exited = true;
+  third.join();
+
+  auto log = read_flight_log(path);
+  REQUIRE(log);
+  CHECK_EQ(log->overflow, 3);
+  REQUIRE_EQ(log->entries.size(), 3);
+  CHECK_NE(log->entries[0].thread, log->entries[1].thread);
+  CHECK_NE(log->entries[1].thread, log->entries[2].thread);
+  int last = 0;
+  std::memcpy(&last, log->entries[2].bytes, sizeof(int));
+  CHECK_EQ(last, 4);
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Flight recorder reuses the rings of exited threads") {
+  std::string path = flight_path("churn");
+  flight_recorder recorder(path, 2, 64);
+  std::uint32_t id = recorder.declare<int>("value");
+  for (int n = 0; n < 10; n++)
+    std::thread([&recorder, id, n]() { recorder.record(id, n); }).join();
+
+  auto log = read_flight_log(path);
+  REQUIRE(log);
+  CHECK_EQ(log->overflow, 0);
+  REQUIRE_EQ(log->entries.size(), 10);
+  for (int n = 0; n < 10; n++) {
+    int value = -1;
+    std::memcpy(&value, log->entries[n].bytes, sizeof(int));
+    CHECK_EQ(value, n);
+  }
+  CHECK_NE(log->entries[0].thread, log->entries[9].thread);
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Flight log rejects other files") {
+  std::string path = flight_path("bad");
+  FILE *file = std::fopen(path.c_str(), "w");
+  std::fputs("definitely not a flight recorder file, but long enough to "
+             "cover the whole header of one",
+             file);
+  std::fclose(file);
+  CHECK_FALSE(read_flight_log(path));
+  std::remove(path.c_str());
+  CHECK_FALSE(read_flight_log(path));
+}
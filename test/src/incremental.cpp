@@ -0,0 +1,125 @@
+#include "incremental.hpp"
+#include "property.hpp"
+#include "doctest/doctest.h"
+
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace properties;
+
+namespace {
+struct temp_store {
+  temp_store()
+      : root{std::filesystem::temp_directory_path() /
+             ("prop-incremental-test-" + std::to_string(::getpid()))} {
+    std::filesystem::remove_all(root);
+  }
+  ~temp_store() { std::filesystem::remove_all(root); }
+
+  std::filesystem::path root;
+};
+} // namespace
+
+TEST_CASE("Content store") {
+  temp_store tmp;
+  content_store store(tmp.root);
+
+  auto hash = store.put("contents");
+  CHECK_EQ(store.get(hash).value(), "contents");
+  CHECK_EQ(store.put("contents"), hash);
+  CHECK_FALSE(store.get(hash + 1).has_value());
+
+  CHECK_FALSE(store.lookup(42).has_value());
+  store.link(42, hash);
+  CHECK_EQ(store.lookup(42).value(), hash);
+}
+
+TEST_CASE("Content store tolerates concurrent writers") {
+  temp_store tmp;
+  content_store store(tmp.root);
+  std::vector<std::thread> writers;
+  for (std::uint64_t i = 0; i < 4; i++)
+    writers.emplace_back([&store, i]() {
+      for (std::uint64_t j = 0; j < 50; j++)
+        store.link(7, i * 1000 + j);
+    });
+  for (auto &w : writers)
+    w.join();
+
+  auto hash = store.lookup(7);
+  REQUIRE(hash.has_value());
+  CHECK_EQ(*hash % 1000, 49);
+  std::size_t files = 0;
+  for (const auto &entry :
+       std::filesystem::directory_iterator(tmp.root / "keys")) {
+    CHECK_EQ(entry.path().extension().string(), "");
+    files++;
+  }
+  CHECK_EQ(files, 1);
+}
+
+TEST_CASE("Derived values load across runs") {
+  temp_store tmp;
+  int calls = 0;
+  auto length = [&calls](const std::string &s) {
+    calls++;
+    return (int)s.size();
+  };
+
+  {
+    content_store store(tmp.root);
+    property<std::string, true> input(std::string("hello"));
+    derived<int, std::string> len(store, "length", length, input);
+    CHECK_EQ(len.get(), 5);
+    CHECK_EQ(len.computed(), 1);
+  }
+
+  content_store store(tmp.root);
+  property<std::string, true> input(std::string("hello"));
+  derived<int, std::string> len(store, "length", length, input);
+  CHECK_EQ(len.get(), 5);
+  CHECK_EQ(len.loaded(), 1);
+  CHECK_EQ(len.computed(), 0);
+  CHECK_EQ(calls, 1);
+
+  input = std::string("hi");
+  CHECK_EQ(len.get(), 2);
+  CHECK_EQ(calls, 2);
+}
+
+TEST_CASE("Derived values early cutoff") {
+  temp_store tmp;
+  content_store store(tmp.root);
+  property<int, true> input(3);
+  int parity_calls = 0;
+  int label_calls = 0;
+
+  derived<int, int> parity(
+      store, "parity",
+      [&parity_calls](const int &x) {
+        parity_calls++;
+        return x % 2;
+      },
+      input);
+  derived<std::string, int> label(
+      store, "label",
+      [&label_calls](const int &p) {
+        label_calls++;
+        return std::string(p ? "odd" : "even");
+      },
+      parity);
+
+  CHECK_EQ(label.get(), "odd");
+  input = 5;
+  CHECK_EQ(parity_calls, 2);
+  CHECK_EQ(parity.cutoffs(), 1);
+  CHECK_EQ(label_calls, 1);
+
+  input = 4;
+  CHECK_EQ(label.get(), "even");
+  CHECK_EQ(label_calls, 2);
+}
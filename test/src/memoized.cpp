@@ -0,0 +1,105 @@
+#include "memoized.hpp"
+#include "property.hpp"
+#include "doctest/doctest.h"
+
+#include <string>
+
+using namespace properties;
+
+TEST_CASE("LRU cache eviction") {
+  lru_cache<int, std::string> cache(2);
+
+  cache.insert(1, "one");
+  cache.insert(2, "two");
+  REQUIRE(cache.find(1) != nullptr);
+  cache.insert(3, "three");
+
+  CHECK_EQ(cache.size(), 2);
+  CHECK(cache.find(2) == nullptr);
+  CHECK_EQ(*cache.find(1), "one");
+  CHECK_EQ(*cache.find(3), "three");
+}
+
+TEST_CASE("Memoized value initial computation") {
+  property<int, true> a(2);
+  property<int, true> b(3);
+  int calls = 0;
+
+  memoized<int, int, int> product(
+      4,
+      [&calls](const int &x, const int &y) {
+        calls++;
+        return x * y;
+      },
+      a, b);
+
+  CHECK_EQ(product.get(), 6);
+  CHECK_EQ(calls, 1);
+  CHECK_EQ(product.misses(), 1);
+}
+
+TEST_CASE("Memoized value cache hits") {
+  int raw = 2;
+  property<int> a(raw);
+  property<int, true> b(3);
+  int calls = 0;
+  int events = 0;
+
+  memoized<int, int, int> sum(
+      4,
+      [&calls](const int &x, const int &y) {
+        calls++;
+        return x + y;
+      },
+      a, b);
+  auto callback = [&events](const int &) { events++; };
+  sum + callback;
+
+  a = 10;
+  CHECK_EQ(sum.get(), 13);
+  CHECK_EQ(calls, 2);
+
+  a = 2;
+  CHECK_EQ(sum.get(), 5);
+  CHECK_EQ(calls, 2);
+  CHECK_EQ(sum.hits(), 1);
+  CHECK_EQ(events, 2);
+
+  sum.invalidate();
+  CHECK_EQ(calls, 3);
+  CHECK_EQ(events, 3);
+}
+
+TEST_CASE("Memoized value eviction") {
+  property<int, true> a(0);
+  int calls = 0;
+
+  memoized<int, int> twice(
+      2,
+      [&calls](const int &x) {
+        calls++;
+        return 2 * x;
+      },
+      a);
+
+  a = 1;
+  a = 2;
+  CHECK_EQ(twice.size(), 2);
+  a = 0;
+  CHECK_EQ(calls, 4);
+  a = 2;
+  CHECK_EQ(calls, 4);
+  CHECK_EQ(twice.get(), 4);
+}
+
+TEST_CASE("Chained memoized values") {
+  property<int, true> a(3);
+  memoized<int, int> square(
+      4, [](const int &x) { return x * x; }, a);
+  memoized<int, int> plus_one(
+      4, [](const int &x) { return x + 1; }, square);
+
+  CHECK_EQ(plus_one.get(), 10);
+  a = 4;
+  CHECK_EQ(plus_one.get(), 17);
+}
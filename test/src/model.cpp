@@ -0,0 +1,84 @@
+#include "shapes.hpp"
+#include "doctest/doctest.h"
+
+#include <string>
+#include <vector>
+
+using namespace properties;
+
+TEST_CASE("Generated model fields") {
+  shapes::point p;
+
+  CHECK_EQ(shapes::point::field_count, 5);
+  CHECK_EQ(std::string(shapes::point::fields[2].name), "label");
+  CHECK_EQ(shapes::point::fields[3].mask, shapes::point::layer_bit);
+  CHECK(p.visible.get());
+  CHECK_EQ(p.layer.get(), 1);
+
+  std::vector<std::string> names;
+  p.for_each_field([&names](const field_info &info, auto &) {
+    names.push_back(info.name);
+  });
+  CHECK_EQ(names.size(), 5);
+  CHECK_EQ(names[0], "visible");
+}
+
+TEST_CASE("Generated model change tracking") {
+  shapes::point p;
+  std::vector<change_mask> events;
+  auto callback = [&events](change_mask mask) { events.push_back(mask); };
+  p + callback;
+
+  p.x = 2.0;
+  p.label.set("a");
+  CHECK_EQ(p.changes(), shapes::point::x_bit | shapes::point::label_bit);
+  CHECK_EQ(events.size(), 2);
+
+  p.clear_changes();
+  p.begin_batch();
+  p.y = 1.0;
+  p.layer = 3;
+  p.end_batch();
+  CHECK_EQ(events.size(), 3);
+  CHECK_EQ(events.back(), shapes::point::y_bit | shapes::point::layer_bit);
+}
+
+TEST_CASE("Generated model diff and apply") {
+  shapes::point a;
+  shapes::point b;
+  b.x = 4.0;
+  b.label.set("b");
+
+  change_mask mask = a.diff(b);
+  CHECK_EQ(mask, shapes::point::x_bit | shapes::point::label_bit);
+
+  int events = 0;
+  auto callback = [&events](change_mask) { events++; };
+  a + callback;
+  a.apply(b, mask);
+  CHECK_EQ(events, 1);
+  CHECK_EQ(a.diff(b), 0);
+}
+
+TEST_CASE("Generated model serialization") {
+  shapes::polygon a;
+  a.indices.set({1, 2, 3});
+  a.flags = 7;
+
+  std::string bytes;
+  a.serialize(bytes);
+
+  shapes::polygon b;
+  CHECK(b.deserialize(bytes));
+  CHECK_EQ(b.diff(a), 0);
+  CHECK_EQ(b.changes(),
+           shapes::polygon::indices_bit | shapes::polygon::flags_bit);
+  CHECK_FALSE(b.deserialize(bytes.substr(1)));
+}
+
+TEST_CASE("Generated model defaults keep comment markers in literals") {
+  shapes::style s;
+  CHECK_EQ(s.link.get(), "http://example.com/#top");
+  CHECK_EQ(s.mark.get(), '#');
+  CHECK_EQ(s.quoted.get(), "say \"#1\" // twice");
+}
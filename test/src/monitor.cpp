@@ -0,0 +1,111 @@
+#include "event.hpp"
+#include "monitor.hpp"
+#include "property.hpp"
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace properties;
+
+namespace {
+void spin(std::chrono::microseconds duration) {
+  auto end = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < end)
+    ;
+}
+} // namespace
+
+TEST_CASE("Unmonitored events have no statistics") {
+  event<int> e;
+  auto callback = [](int) {};
+  e + callback;
+  e.trigger(1);
+  CHECK(e.listener_statistics().empty());
+}
+
+TEST_CASE("Monitoring flags slow listeners") {
+  listener_policy policy;
+  policy.budget = std::chrono::microseconds(200);
+  policy.strikes = 2;
+
+  property<int, true> p(0);
+  int fast_calls = 0;
+  bool slow = false;
+  p + [&fast_calls](int &) { fast_calls++; };
+  p + [&slow](int &) {
+    if (slow)
+      spin(std::chrono::microseconds(1000));
+  };
+  p.monitor_listeners(policy);
+
+  p.set(1);
+  slow = true;
+  p.set(2);
+  auto stats = p.listener_statistics();
+  REQUIRE_EQ(stats.size(), 2);
+  CHECK_EQ(stats[1].over_budget, 1);
+  CHECK_FALSE(stats[1].flagged);
+
+  p.set(3);
+  stats = p.listener_statistics();
+  CHECK_EQ(stats[0].calls, 3);
+  CHECK_FALSE(stats[0].flagged);
+  CHECK(stats[1].flagged);
+  CHECK_FALSE(stats[1].async);
+  CHECK_GE(stats[1].max_ns, 1000000);
+  CHECK_EQ(fast_calls, 3);
+}
+
+TEST_CASE("Flagged listeners are demoted to the pool") {
+  listener_pool pool(2);
+  listener_policy policy;
+  policy.budget = std::chrono::microseconds(200);
+  policy.strikes = 1;
+  policy.pool = &pool;
+
+  property<int, true> p(0);
+  std::atomic<int> slow_calls{0};
+  std::vector<int> seen;
+  std::thread::id writer = std::this_thread::get_id();
+  std::atomic<bool> off_thread{false};
+  p + [&](int &value) {
+    if (std::this_thread::get_id() != writer)
+      off_thread = true;
+    seen.push_back(value);
+    slow_calls++;
+    spin(std::chrono::microseconds(1000));
+  };
+  p.monitor_listeners(policy);
+
+  p.set(1);
+  CHECK(p.listener_statistics()[0].async);
+  for (int i = 2; i <= 5; i++)
+    p.set(i);
+
+  pool.wait_idle();
+  CHECK_EQ(slow_calls.load(), 5);
+  CHECK(off_thread.load());
+  REQUIRE_EQ(seen.size(), 5);
+  bool ordered = true;
+  for (std::size_t i = 0; i < seen.size(); i++)
+    ordered = ordered && seen[i] == static_cast<int>(i) + 1;
+  CHECK(ordered);
+}
+
+TEST_CASE("Copied events keep the monitoring policy") {
+  listener_policy policy;
+  event<int> e;
+  auto callback = [](int) {};
+  e + callback;
+  e.monitor_listeners(policy);
+  e.trigger(1);
+
+  event<int> copy = e;
+  CHECK_EQ(e.listener_statistics()[0].calls, 1);
+  CHECK(copy.listener_statistics().empty());
+  copy.trigger(2);
+  CHECK_EQ(copy.listener_statistics()[0].calls, 1);
+}
@@ -0,0 +1,94 @@
+#include "no_alloc.hpp"
+#include "event.hpp"
+#include "property.hpp"
+#include "doctest/doctest.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+PROP_DEFINE_ALLOC_GUARD();
+
+using namespace properties;
+
+namespace {
+std::size_t reported = 0;
+void record(std::size_t) { reported++; }
+
+struct point {
+  double x;
+  double y;
+};
+} // namespace
+
+TEST_CASE("No-alloc scope detects allocations") {
+  auto previous = set_alloc_violation_handler(&record);
+  reported = 0;
+  {
+    no_alloc_scope guard;
+    std::vector<int> v(16);
+    CHECK_EQ(guard.violations(), 1);
+    {
+      no_alloc_scope inner;
+      std::string s(64, 'x');
+      CHECK_EQ(inner.violations(), 1);
+    }
+    CHECK_EQ(guard.violations(), 2);
+  }
+  std::vector<int> outside(16);
+  CHECK_EQ(reported, 2);
+  set_alloc_violation_handler(previous);
+}
+
+TEST_CASE("Setting properties doesn't allocate") {
+  auto previous = set_alloc_violation_handler(&record);
+  int i = 0;
+  int sum = 0;
+  property<int> by_reference(i);
+  property<point, true> by_value(point{0, 0});
+  std::array<int, 2> small{{1, 2}};
+  by_reference + [&sum, small](int &v) { sum += v + small[0]; };
+  by_value + [&sum](point &p) { sum += static_cast<int>(p.x); };
+  by_reference.set(0);
+  by_value.set(point{0, 0});
+
+  no_alloc_scope guard;
+  for (int n = 0; n < 100; n++) {
+    by_reference.set(n);
+    by_value.set(point{1.0 * n, 2.0});
+  }
+  CHECK_EQ(guard.violations(), 0);
+  set_alloc_violation_handler(previous);
+}
+
+TEST_CASE("Triggering events doesn't allocate") {
+  auto previous = set_alloc_violation_handler(&record);
+  event<int> e;
+  int sum = 0;
+  std::array<char, 128> large{};
+  auto small = [&sum](int v) { sum += v; };
+  auto spilled = [&sum, large](int v) { sum += v + large[0]; };
+  e + small;
+  e + spilled;
+  e.trigger(0);
+
+  no_alloc_scope guard;
+  for (int n = 0; n < 100; n++)
+    e.trigger(n);
+  CHECK_EQ(guard.violations(), 0);
+  set_alloc_violation_handler(previous);
+}
+
+TEST_CASE("Monitored dispatch doesn't allocate") {
+  auto previous = set_alloc_violation_handler(&record);
+  property<int, true> p(0);
+  p + [](int &) {};
+  p.monitor_listeners(listener_policy{});
+  p.set(1);
+
+  no_alloc_scope guard;
+  for (int n = 0; n < 100; n++)
+    p.set(n);
+  CHECK_EQ(guard.violations(), 0);
+  set_alloc_violation_handler(previous);
+}
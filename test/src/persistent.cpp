@@ -0,0 +1,118 @@
+#include "persistent.hpp"
+#include "property.hpp"
+#include "doctest/doctest.h"
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace properties;
+
+TEST_CASE("Persistent vector push and pop") {
+  persistent_vector<int> v;
+  std::vector<persistent_vector<int>> versions;
+
+  for (int i = 0; i < 2000; i++) {
+    versions.push_back(v);
+    v = v.push_back(i);
+  }
+  CHECK_EQ(v.size(), 2000);
+  for (int i = 0; i < 2000; i++)
+    REQUIRE_EQ(v[i], i);
+  for (std::size_t i = 0; i < versions.size(); i += 97)
+    CHECK_EQ(versions[i].size(), i);
+
+  int expected = 0;
+  for (int value : v)
+    REQUIRE_EQ(value, expected++);
+  CHECK_EQ(expected, 2000);
+
+  for (int i = 1999; i >= 0; i--) {
+    REQUIRE_EQ(v[v.size() - 1], i);
+    v = v.pop_back();
+    if (i % 131 == 0)
+      for (std::size_t j = 0; j < v.size(); j++)
+        REQUIRE_EQ(v[j], (int)j);
+  }
+  CHECK(v.empty());
+}
+
+TEST_CASE("Persistent vector set keeps old versions") {
+  persistent_vector<std::string> v;
+  for (int i = 0; i < 100; i++)
+    v = v.push_back(std::to_string(i));
+
+  auto changed = v.set(5, "five").set(99, "last");
+  CHECK_EQ(v[5], "5");
+  CHECK_EQ(v[99], "99");
+  CHECK_EQ(changed[5], "five");
+  CHECK_EQ(changed[99], "last");
+  CHECK_EQ(changed[6], "6");
+}
+
+namespace {
+struct bad_hash {
+  std::size_t operator()(int v) const { return v % 3; }
+};
+} // namespace
+
+TEST_CASE("Persistent map matches std::map") {
+  persistent_map<int, int> m;
+  std::map<int, int> reference;
+  std::mt19937 rng(1234);
+
+  for (int i = 0; i < 5000; i++) {
+    int key = rng() % 700;
+    if (rng() % 3 == 0) {
+      m = m.erase(key);
+      reference.erase(key);
+    } else {
+      m = m.set(key, i);
+      reference[key] = i;
+    }
+  }
+
+  CHECK_EQ(m.size(), reference.size());
+  for (const auto &[key, value] : reference) {
+    REQUIRE(m.find(key) != nullptr);
+    REQUIRE_EQ(*m.find(key), value);
+  }
+  std::size_t visited = 0;
+  for (const auto &[key, value] : m) {
+    REQUIRE_EQ(reference.at(key), value);
+    visited++;
+  }
+  CHECK_EQ(visited, reference.size());
+}
+
+TEST_CASE("Persistent map hash collisions") {
+  persistent_map<int, std::string, bad_hash> m;
+  for (int i = 0; i < 30; i++)
+    m = m.set(i, std::to_string(i));
+
+  auto smaller = m.erase(3).erase(4).erase(100);
+  CHECK_EQ(m.size(), 30);
+  CHECK_EQ(smaller.size(), 28);
+  CHECK_FALSE(smaller.contains(3));
+  CHECK(m.contains(3));
+  for (int i = 5; i < 30; i++)
+    REQUIRE_EQ(*smaller.find(i), std::to_string(i));
+}
+
+TEST_CASE("Property snapshots of persistent values") {
+  property<persistent_map<std::string, int>, true> p(
+      persistent_map<std::string, int>{});
+  int calls = 0;
+  auto callback = [&calls](persistent_map<std::string, int> &) { calls++; };
+  p + callback;
+
+  p = p.get().set("a", 1);
+  auto snapshot = p.get();
+  p = p.get().set("a", 2).set("b", 3);
+
+  CHECK_EQ(calls, 2);
+  CHECK_EQ(*snapshot.find("a"), 1);
+  CHECK_FALSE(snapshot.contains("b"));
+  CHECK_EQ(*p.get().find("a"), 2);
+}
@@ -0,0 +1,94 @@
+#include "prometheus.hpp"
+#include "event.hpp"
+#include "property.hpp"
+#include "doctest/doctest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace properties;
+
+TEST_CASE("Event metrics count triggers") {
+  event_metrics metrics;
+  event<int> e;
+  auto callback = [](int) {};
+  e + callback;
+  e.attach_metrics(&metrics);
+  e + callback;
+
+  e.trigger(1);
+  e.trigger(2);
+  auto s = metrics.collect();
+  CHECK_EQ(s.triggers, 2);
+  CHECK_EQ(s.listener_calls, 4);
+  CHECK_EQ(s.listeners, 2);
+  std::uint64_t observed = 0;
+  for (auto count : s.histogram)
+    observed += count;
+  CHECK_EQ(observed, 2);
+
+  e.attach_metrics(nullptr);
+  e.trigger(3);
+  CHECK_EQ(metrics.collect().triggers, 2);
+}
+
+TEST_CASE("Event metrics combine thread shards") {
+  event_metrics metrics;
+  property<int, true> p(0);
+  p.attach_metrics(&metrics);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++)
+    threads.emplace_back([&metrics]() {
+      for (int i = 0; i < 1000; i++)
+        metrics.record(1, 10);
+    });
+  for (auto &thread : threads)
+    thread.join();
+  p.set(1);
+  CHECK_EQ(metrics.collect().triggers, 4001);
+}
+
+TEST_CASE("Registry renders the Prometheus text format") {
+  metrics_registry registry;
+  property<int, true> speed(0);
+  event<int> tick;
+  speed + [](int &) {};
+  registry.track("speed", speed);
+  registry.track("tick \"main\"", tick);
+
+  for (int i = 0; i < 10; i++)
+    speed.set(i);
+  tick.trigger(1);
+
+  std::string text = registry.render();
+  CHECK_NE(text.find("# TYPE prop_event_triggers_total counter\n"),
+           std::string::npos);
+  CHECK_NE(text.find("prop_event_triggers_total{event=\"speed\"} 10\n"),
+           std::string::npos);
+  CHECK_NE(text.find("prop_event_triggers_total{event=\"tick \\\"main\\\"\"} "
+                     "1\n"),
+           std::string::npos);
+  CHECK_NE(text.find("prop_event_listeners{event=\"speed\"} 1\n"),
+           std::string::npos);
+  CHECK_NE(text.find("prop_event_dispatch_seconds{event=\"speed\","
+                     "quantile=\"0.99\"}"),
+           std::string::npos);
+  CHECK_NE(text.find("prop_event_dispatch_seconds_count{event=\"speed\"} 10\n"),
+           std::string::npos);
+
+  std::string path = "/tmp/prop_metrics_" + std::to_string(::getpid());
+  REQUIRE(registry.write(path));
+  std::ifstream in(path);
+  std::stringstream contents;
+  contents << in.rdbuf();
+  CHECK_NE(contents.str().find("prop_event_listener_calls_total"),
+           std::string::npos);
+  std::remove(path.c_str());
+}
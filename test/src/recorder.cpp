@@ -0,0 +1,116 @@
+#include "recorder.hpp"
+#include "property.hpp"
+#include "doctest/doctest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace properties;
+
+TEST_CASE("Ring publishes in batches") {
+  spsc_ring<int, 8, 4> ring;
+  int out[8];
+
+  CHECK(ring.push(1));
+  CHECK(ring.push(2));
+  CHECK(ring.push(3));
+  CHECK_EQ(ring.read(out, 8), 0);
+  CHECK(ring.push(4));
+  CHECK_EQ(ring.read(out, 8), 4);
+  CHECK_EQ(out[0], 1);
+  CHECK_EQ(out[3], 4);
+
+  CHECK(ring.push(5));
+  ring.flush();
+  int sum = 0;
+  CHECK_EQ(ring.drain([&sum](const int &v) { sum += v; }), 1);
+  CHECK_EQ(sum, 5);
+}
+
+TEST_CASE("Ring rejects pushes when full") {
+  spsc_ring<int, 4, 1> ring;
+  for (int i = 0; i < 4; i++)
+    CHECK(ring.push(i));
+  CHECK_FALSE(ring.push(4));
+
+  int out[2];
+  CHECK_EQ(ring.read(out, 2), 2);
+  CHECK_EQ(out[0], 0);
+  CHECK(ring.push(4));
+  CHECK(ring.push(5));
+  CHECK_FALSE(ring.push(6));
+
+  int rest[4];
+  CHECK_EQ(ring.read(rest, 4), 4);
+  CHECK_EQ(rest[0], 2);
+  CHECK_EQ(rest[3], 5);
+}
+
+TEST_CASE("Recorder records property changes") {
+  struct point {
+    float x;
+    float y;
+  };
+  int i = 0;
+  property<int> p(i);
+  property<point, true> q(point{0, 0});
+  change_recorder<16, 4> recorder;
+
+  std::uint32_t pid = recorder.watch(p);
+  std::uint32_t qid = recorder.watch(q);
+  CHECK_NE(pid, qid);
+
+  p.set(1);
+  q.set(point{2, 3});
+  p.set(4);
+  recorder.flush();
+
+  change_record records[16];
+  REQUIRE_EQ(recorder.read(records, 16), 3);
+  CHECK_EQ(records[0].id, pid);
+  CHECK_EQ(records[0].as<int>(), 1);
+  CHECK_EQ(records[1].id, qid);
+  CHECK_EQ(records[1].size, sizeof(point));
+  CHECK_EQ(records[1].as<point>().y, 3.0f);
+  CHECK_EQ(records[2].as<int>(), 4);
+
+  for (int n = 0; n < 20; n++)
+    p.set(n);
+  CHECK_EQ(recorder.dropped(), 4);
+}
+
+TEST_CASE("Recorder between threads") {
+  int i = 0;
+  property<int> p(i);
+  change_recorder<256, 16> recorder;
+  recorder.watch(p);
+  std::atomic<bool> done{false};
+  std::vector<int> seen;
+  std::size_t drops_seen = 0;
+
+  std::thread consumer([&]() {
+    for (;;) {
+      bool finished = done.load();
+      drops_seen = std::max(drops_seen, recorder.dropped());
+      std::size_t count = recorder.drain(
+          [&seen](const change_record &r) { seen.push_back(r.as<int>()); });
+      if (count == 0 && finished)
+        break;
+    }
+  });
+
+  for (int n = 1; n <= 100000; n++)
+    p.set(n);
+  recorder.flush();
+  done = true;
+  consumer.join();
+
+  CHECK_EQ(seen.size() + recorder.dropped(), 100000);
+  CHECK_LE(drops_seen, recorder.dropped());
+  bool ordered = true;
+  for (std::size_t n = 1; n < seen.size(); n++)
+    ordered = ordered && seen[n - 1] < seen[n];
+  CHECK(ordered);
+}
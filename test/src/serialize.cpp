@@ -0,0 +1,70 @@
+#include "serialize.hpp"
+#include "doctest/doctest.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace properties;
+
+namespace {
+struct unpadded {
+  int a;
+  int b;
+};
+
+struct padded {
+  char tag;
+  int value;
+};
+} // namespace
+
+template <> struct properties::serializer<padded> {
+  static void write(std::string &out, const padded &value) {
+    serializer<char>::write(out, value.tag);
+    serializer<int>::write(out, value.value);
+  }
+
+  static bool read(std::string_view &in, padded &value) {
+    return serializer<char>::read(in, value.tag) &&
+           serializer<int>::read(in, value.value);
+  }
+};
+
+TEST_CASE("Serialize trivially copyable values") {
+  double out = 0;
+
+  CHECK(deserialize(serialize(2.5), out));
+  CHECK_EQ(out, 2.5);
+  CHECK_FALSE(deserialize(std::string("abc"), out));
+}
+
+TEST_CASE("Serialize containers") {
+  std::vector<std::string> in{"a", "", "hello"};
+  std::vector<std::string> out;
+
+  std::string bytes = serialize(in);
+  CHECK(deserialize(bytes, out));
+  CHECK(out == in);
+
+  bytes.pop_back();
+  CHECK_FALSE(deserialize(bytes, out));
+}
+
+TEST_CASE("Serialize structs without padding bytes") {
+  unpadded u{1, 2};
+  CHECK_EQ(serialize(u).size(), sizeof(unpadded));
+
+  padded a{'x', 7};
+  padded b{'x', 7};
+  std::memset(&b, 0xff, sizeof(b));
+  b.tag = 'x';
+  b.value = 7;
+  std::string bytes = serialize(a);
+  CHECK_EQ(bytes, serialize(b));
+  CHECK_EQ(bytes.size(), sizeof(char) + sizeof(int));
+  padded out{0, 0};
+  CHECK(deserialize(bytes, out));
+  CHECK_EQ(out.tag, 'x');
+  CHECK_EQ(out.value, 7);
+}
@@ -0,0 +1,72 @@
+#include "shared_value.hpp"
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace properties;
+
+namespace {
+struct config {
+  int version;
+  std::vector<int> data;
+};
+} // namespace
+
+TEST_CASE("Shared value snapshots") {
+  shared_value_property<std::string> p(std::string("first"));
+  auto snapshot = p.get();
+
+  p.set(std::string("second"));
+  CHECK_EQ(*snapshot, "first");
+  CHECK_EQ(*p.get(), "second");
+  CHECK_EQ(p.read([](const std::string &s) { return s.size(); }), 6);
+}
+
+TEST_CASE("Shared value event fires after publication") {
+  shared_value_property<int> p(1);
+  int seen = 0;
+  auto callback = [&p, &seen](const std::shared_ptr<const int> &v) {
+    CHECK_EQ(*v, 2);
+    seen = *p.get();
+  };
+  p + callback;
+
+  p.set(2);
+  CHECK_EQ(seen, 2);
+}
+
+TEST_CASE("Shared value concurrent readers") {
+  shared_value_property<config> p(config{0, std::vector<int>(64, 0)});
+  std::atomic<bool> done{false};
+  std::atomic<int> errors{0};
+
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&]() {
+      int last = 0;
+      while (!done.load()) {
+        auto snapshot = p.get();
+        p.read([&](const config &c) {
+          for (int v : c.data)
+            if (v != c.version)
+              errors++;
+        });
+        if (snapshot->version < last)
+          errors++;
+        last = snapshot->version;
+      }
+    });
+  }
+
+  for (int i = 1; i <= 2000; i++)
+    p.set(config{i, std::vector<int>(64, i)});
+  done = true;
+  for (auto &reader : readers)
+    reader.join();
+
+  CHECK_EQ(errors.load(), 0);
+  CHECK_EQ(p.get()->version, 2000);
+}
@@ -0,0 +1,83 @@
+#include "thread_local.hpp"
+#include "doctest/doctest.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace properties;
+
+TEST_CASE("Thread-local values are per thread") {
+  thread_local_property<int> p(0);
+
+  p.set_local(5);
+  std::thread other([&p]() {
+    CHECK_EQ(p.local(), 0);
+    p.set_local(7);
+    CHECK_EQ(p.local(), 7);
+  });
+  other.join();
+
+  CHECK_EQ(p.local(), 5);
+  CHECK_EQ(p.get(), 12);
+}
+
+TEST_CASE("Thread-local counters") {
+  thread_local_property<long> counter(0);
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t < 4; t++) {
+    workers.emplace_back([&counter]() {
+      for (int i = 0; i < 10000; i++)
+        counter.update_local([](long v) { return v + 1; });
+    });
+  }
+  for (auto &worker : workers)
+    worker.join();
+
+  CHECK_EQ(counter.get(), 40000);
+}
+
+TEST_CASE("Thread-local broadcast") {
+  auto max = [](const int &a, const int &b) { return std::max(a, b); };
+  thread_local_property<int, decltype(max)> size(16, max);
+  int calls = 0;
+  auto callback = [&calls](const int &v) {
+    calls++;
+    CHECK_EQ(v, 64);
+  };
+  size + callback;
+
+  CHECK_EQ(size.get(), 16);
+  size.set_local(32);
+  CHECK_EQ(size.get(), 32);
+
+  size.set(64);
+  CHECK_EQ(calls, 1);
+  CHECK_EQ(size.local(), 64);
+
+  std::thread other([&size]() { CHECK_EQ(size.local(), 64); });
+  other.join();
+}
+
+TEST_CASE("Thread-local broadcast with a summing reducer") {
+  thread_local_property<int> sum(0);
+  CHECK_EQ(sum.get(), 0);
+  sum.set(5);
+  // no slot was used yet
+  CHECK_EQ(sum.get(), 5);
+  CHECK_EQ(sum.local(), 5);
+  CHECK_EQ(sum.get(), 5);
+
+  std::thread other([&sum]() { CHECK_EQ(sum.local(), 5); });
+  other.join();
+  // one broadcast value per used slot
+  CHECK_EQ(sum.get(), 10);
+
+  sum.set(3);
+  CHECK_EQ(sum.get(), 6);
+
+  thread_local_property<int> single(1);
+  CHECK_EQ(single.local(), 1);
+  CHECK_EQ(single.get(), 1);
+}
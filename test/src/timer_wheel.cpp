@@ -0,0 +1,180 @@
+#include "timer_wheel.hpp"
+#include "event.hpp"
+#include "property.hpp"
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace properties;
+using namespace std::chrono_literals;
+
+namespace {
+const timer_wheel::clock::time_point epoch{};
+} // namespace
+
+TEST_CASE("Timers fire in order, and not early") {
+  timer_wheel wheel(1ms, epoch);
+  std::vector<int> fired;
+  wheel.schedule_at(epoch + 30ms, [&fired]() { fired.push_back(3); });
+  wheel.schedule_at(epoch + 10ms, [&fired]() { fired.push_back(1); });
+  wheel.schedule_at(epoch + 20ms, [&fired]() { fired.push_back(2); });
+  CHECK_EQ(wheel.size(), 3);
+
+  CHECK_EQ(wheel.advance(epoch + 9ms), 0);
+  CHECK(fired.empty());
+  CHECK_EQ(wheel.advance(epoch + 10ms), 1);
+  CHECK_EQ(wheel.advance(epoch + 40ms), 2);
+  REQUIRE_EQ(fired.size(), 3);
+  CHECK_EQ(fired[0], 1);
+  CHECK_EQ(fired[1], 2);
+  CHECK_EQ(fired[2], 3);
+  CHECK_EQ(wheel.size(), 0);
+
+  // deadlines in the past fire at the next tick
+  wheel.schedule_at(epoch, [&fired]() { fired.push_back(4); });
+  CHECK_EQ(wheel.advance(epoch + 41ms), 1);
+  CHECK_EQ(fired.back(), 4);
+
+  // deadlines between ticks are rounded up
+  wheel.schedule_at(epoch + 50900us, [&fired]() { fired.push_back(5); });
+  CHECK_EQ(wheel.advance(epoch + 50ms), 0);
+  CHECK_EQ(wheel.advance(epoch + 50899us), 0);
+  CHECK_EQ(wheel.advance(epoch + 51ms), 1);
+  CHECK_EQ(fired.back(), 5);
+
+  timer_wheel coarse(100ms, epoch);
+  int late = 0;
+  coarse.schedule_at(epoch + 199ms, [&late]() { late++; });
+  CHECK_EQ(coarse.advance(epoch + 100ms), 0);
+  CHECK_EQ(coarse.advance(epoch + 199ms), 0);
+  CHECK_EQ(coarse.advance(epoch + 200ms), 1);
+  CHECK_EQ(late, 1);
+}
+
+TEST_CASE("Cancelled timers don't fire") {
+  timer_wheel wheel(1ms, epoch);
+  int fired = 0;
+  auto a = wheel.schedule_at(epoch + 5ms, [&fired]() { fired++; });
+  auto b = wheel.schedule_at(epoch + 5ms, [&fired]() { fired += 10; });
+  CHECK(wheel.cancel(a));
+  CHECK_FALSE(wheel.cancel(a));
+  CHECK_EQ(wheel.size(), 1);
+  CHECK_EQ(wheel.advance(epoch + 5ms), 1);
+  CHECK_EQ(fired, 10);
+  CHECK_FALSE(wheel.cancel(b));
+
+  // the slot of a is reused, but its old id stays stale
+  auto c = wheel.schedule_at(epoch + 6ms, [&fired]() { fired += 100; });
+  CHECK_FALSE(wheel.cancel(a));
+  CHECK_FALSE(wheel.cancel(timer_id{}));
+  CHECK(wheel.cancel(c));
+  wheel.advance(epoch + 10ms);
+  CHECK_EQ(fired, 10);
+}
+
+TEST_CASE("Long delays cascade through the levels") {
+  timer_wheel wheel(1ms, epoch);
+  std::vector<timer_wheel::clock::duration> delays{
+      255ms, 256ms, 300ms, 65535ms, 65536ms, 70s, 5h, 60 * 24h};
+  std::vector<timer_wheel::clock::time_point> fired;
+  timer_wheel::clock::time_point now = epoch;
+  for (auto delay : delays)
+    wheel.schedule_at(epoch + delay,
+                      [&fired, &now]() { fired.push_back(now); });
+
+  for (auto delay : delays) {
+    now = epoch + delay - 1ms;
+    CHECK_EQ(wheel.advance(now), 0);
+    now = epoch + delay;
+    CHECK_EQ(wheel.advance(now), 1);
+  }
+  REQUIRE_EQ(fired.size(), delays.size());
+  for (std::size_t i = 0; i < delays.size(); i++)
+    CHECK(fired[i] == epoch + delays[i]);
+}
+
+TEST_CASE("Scheduled writes notify listeners") {
+  timer_wheel wheel(1ms, epoch);
+  property<int, true> p(0);
+  int seen = 0;
+  p + [&seen](int &v) { seen = v; };
+  wheel.set_at(p, epoch + 500ms, 7);
+  wheel.advance(epoch + 499ms);
+  CHECK_EQ(p.get(), 0);
+  wheel.advance(epoch + 500ms);
+  CHECK_EQ(p.get(), 7);
+  CHECK_EQ(seen, 7);
+
+  event<int &> e;
+  int sum = 0;
+  auto callback = [&sum](int &v) { sum += v; };
+  e + callback;
+  wheel.trigger_at(e, epoch + 1s, 3);
+  wheel.trigger_at(e, epoch + 2s, 4);
+  wheel.advance(epoch + 1s);
+  CHECK_EQ(sum, 3);
+  wheel.advance(epoch + 2s);
+  CHECK_EQ(sum, 7);
+}
+
+TEST_CASE("Tasks can schedule and cancel timers") {
+  timer_wheel wheel(1ms, epoch);
+  int fired = 0;
+  timer_id later;
+  wheel.schedule_at(epoch + 1ms, [&]() {
+    fired++;
+    wheel.cancel(later);
+    wheel.schedule_at(epoch + 2ms, [&fired]() { fired += 10; });
+  });
+  later = wheel.schedule_at(epoch + 3ms, [&fired]() { fired += 100; });
+  CHECK_EQ(wheel.advance(epoch + 1ms), 1);
+  CHECK_EQ(wheel.size(), 1);
+  CHECK_EQ(wheel.advance(epoch + 5ms), 1);
+  CHECK_EQ(fired, 11);
+}
+
+TEST_CASE("Many timers fire once each") {
+  timer_wheel wheel(1ms, epoch);
+  std::mt19937 random(42);
+  std::uniform_int_distribution<int> delay(1, 200000);
+  std::vector<int> fired(100000, 0);
+  std::vector<timer_id> ids;
+  for (std::size_t i = 0; i < fired.size(); i++)
+    ids.push_back(wheel.schedule_at(epoch + std::chrono::milliseconds(
+                                                delay(random)),
+                                    [&fired, i]() { fired[i]++; }));
+  for (std::size_t i = 0; i < ids.size(); i += 2)
+    CHECK(wheel.cancel(ids[i]));
+  CHECK_EQ(wheel.size(), fired.size() / 2);
+
+  std::size_t total = 0;
+  for (auto now = epoch; now <= epoch + 200s; now += 7s)
+    total += wheel.advance(now);
+  total += wheel.advance(epoch + 200s);
+  CHECK_EQ(total, fired.size() / 2);
+  CHECK_EQ(wheel.size(), 0);
+  bool exact = true;
+  for (std::size_t i = 0; i < fired.size(); i++)
+    exact &= fired[i] == (i % 2 == 0 ? 0 : 1);
+  CHECK(exact);
+}
+
+TEST_CASE("Timer threads advance the wheel") {
+  timer_wheel wheel(1ms);
+  property<int, true> p(0);
+  std::atomic<int> seen{0};
+  p + [&seen](int &v) { seen = v; };
+  {
+    timer_thread driver(wheel);
+    wheel.set_after(p, 5ms, 9);
+    auto give_up = timer_wheel::clock::now() + 5s;
+    while (seen != 9 && timer_wheel::clock::now() < give_up)
+      std::this_thread::sleep_for(1ms);
+  }
+  CHECK_EQ(seen, 9);
+  CHECK_EQ(wheel.size(), 0);
+}
@@ -0,0 +1,110 @@
+#include "transaction.hpp"
+#include "doctest/doctest.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace properties;
+
+TEST_CASE("Transaction commits atomically") {
+  tx_domain domain;
+  tx_property<int> a(domain, 1);
+  tx_property<std::string> b(domain, std::string("one"));
+
+  transaction tx(domain);
+  tx.set(a, 2);
+  tx.set(b, std::string("two"));
+  CHECK_EQ(a.get(), 1);
+  CHECK_EQ(b.get(), "one");
+
+  CHECK_EQ(tx.commit(), 1);
+  CHECK_EQ(a.get(), 2);
+  CHECK_EQ(b.get(), "two");
+}
+
+TEST_CASE("Transaction notifies once after commit") {
+  tx_domain domain;
+  tx_property<int> a(domain, 0);
+  tx_property<int> b(domain, 0);
+  int calls = 0;
+  auto callback = [&](const int &v) {
+    calls++;
+    CHECK_EQ(v, 3);
+    CHECK_EQ(b.get(), 4);
+  };
+  a + callback;
+
+  {
+    transaction tx(domain);
+    tx.set(a, 1);
+    tx.set(b, 4);
+    tx.set(a, 3);
+    tx.commit();
+  }
+  CHECK_EQ(calls, 1);
+
+  {
+    transaction tx(domain);
+    tx.set(a, 5);
+  }
+  CHECK_EQ(a.get(), 3);
+  CHECK_EQ(calls, 1);
+}
+
+TEST_CASE("Read transaction sees a snapshot") {
+  tx_domain domain;
+  tx_property<int> a(domain, 1);
+  tx_property<int> b(domain, 1);
+
+  read_transaction snapshot(domain);
+  for (int i = 2; i < 10; i++) {
+    transaction tx(domain);
+    tx.set(a, i);
+    tx.set(b, i);
+    tx.commit();
+  }
+
+  CHECK_EQ(snapshot.get(a), 1);
+  CHECK_EQ(snapshot.get(b), 1);
+  CHECK_EQ(a.get(), 9);
+
+  read_transaction later(domain);
+  CHECK_EQ(later.get(b), 9);
+}
+
+TEST_CASE("Concurrent readers never see torn commits") {
+  tx_domain domain;
+  tx_property<int> a(domain, 0);
+  tx_property<int> b(domain, 0);
+  tx_property<int> c(domain, 0);
+  std::atomic<bool> done{false};
+  std::atomic<int> errors{0};
+
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 3; t++) {
+    readers.emplace_back([&]() {
+      while (!done.load()) {
+        read_transaction tx(domain);
+        int va = tx.get(a);
+        if (tx.get(b) != va || tx.get(c) != va)
+          errors++;
+      }
+    });
+  }
+
+  for (int i = 1; i <= 3000; i++) {
+    transaction tx(domain);
+    tx.set(a, i);
+    tx.set(b, i);
+    tx.set(c, i);
+    tx.commit();
+  }
+  done = true;
+  for (auto &reader : readers)
+    reader.join();
+
+  CHECK_EQ(errors.load(), 0);
+  CHECK_EQ(c.get(), 3000);
+}
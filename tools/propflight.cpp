@@ -0,0 +1,120 @@
+/*
+ * propflight: decodes a flight recorder file.
+ *
+ * Usage: propflight <file> [-n <count>]
+ *
+ * Prints the records of all threads, oldest first, one per line:
+ *
+ *   -0.001532417  thread 2  speed = 12.5
+ *
+ * The time is relative to the most recent record in the file. With -n, only
+ * the last <count> records are printed.
+ */
+
+#include "flight_recorder.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+using properties::flight_log;
+using properties::flight::kind;
+
+template <typename T> T load(const unsigned char *bytes) {
+  T value;
+  std::memcpy(&value, bytes, sizeof(T));
+  return value;
+}
+
+std::string format(const flight_log::entry &e, kind k) {
+  char buffer[128];
+  switch (k) {
+  case kind::boolean:
+    return e.bytes[0] ? "true" : "false";
+  case kind::signed_integer:
+    if (e.size == 1)
+      return std::to_string(load<std::int8_t>(e.bytes));
+    if (e.size == 2)
+      return std::to_string(load<std::int16_t>(e.bytes));
+    if (e.size == 4)
+      return std::to_string(load<std::int32_t>(e.bytes));
+    if (e.size == 8)
+      return std::to_string(load<std::int64_t>(e.bytes));
+    break;
+  case kind::unsigned_integer:
+    if (e.size == 1)
+      return std::to_string(load<std::uint8_t>(e.bytes));
+    if (e.size == 2)
+      return std::to_string(load<std::uint16_t>(e.bytes));
+    if (e.size == 4)
+      return std::to_string(load<std::uint32_t>(e.bytes));
+    if (e.size == 8)
+      return std::to_string(load<std::uint64_t>(e.bytes));
+    break;
+  case kind::floating_point:
+    if (e.size == sizeof(float)) {
+      std::snprintf(buffer, sizeof(buffer), "%.9g", load<float>(e.bytes));
+      return buffer;
+    }
+    if (e.size == sizeof(double)) {
+      std::snprintf(buffer, sizeof(buffer), "%.17g", load<double>(e.bytes));
+      return buffer;
+    }
+    break;
+  case kind::raw:
+    break;
+  }
+
+  std::string hex = "0x";
+  for (std::uint32_t i = 0; i < e.size; i++) {
+    std::snprintf(buffer, sizeof(buffer), "%02x", e.bytes[i]);
+    hex += buffer;
+  }
+  return hex;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  std::size_t limit = 0;
+  if (argc == 4 && std::string(argv[2]) == "-n") {
+    limit = std::stoul(argv[3]);
+  } else if (argc != 2) {
+    std::cerr << "usage: " << argv[0] << " <file> [-n <count>]\n";
+    return 2;
+  }
+
+  auto log = properties::read_flight_log(argv[1]);
+  if (!log) {
+    std::cerr << argv[1] << ": not a flight recorder file\n";
+    return 1;
+  }
+
+  std::printf("# created %" PRIu64 ".%09" PRIu64 ", %zu records",
+              log->origin / 1000000000, log->origin % 1000000000,
+              log->entries.size());
+  if (log->overflow != 0)
+    std::printf(", %" PRIu64 " dropped (no free ring)", log->overflow);
+  std::printf("\n");
+
+  std::size_t first = 0;
+  if (limit != 0 && log->entries.size() > limit)
+    first = log->entries.size() - limit;
+  std::uint64_t last = log->entries.empty() ? 0 : log->entries.back().time;
+  for (std::size_t i = first; i < log->entries.size(); i++) {
+    const flight_log::entry &e = log->entries[i];
+    std::uint64_t ago = last - e.time;
+    std::string name = "#" + std::to_string(e.id);
+    kind k = kind::raw;
+    if (e.id < log->names.size()) {
+      name = log->names[e.id].text;
+      k = log->names[e.id].value_kind;
+    }
+    std::printf("-%" PRIu64 ".%09" PRIu64 "  thread %" PRIu64 "  %s = %s\n",
+                ago / 1000000000, ago % 1000000000, e.thread, name.c_str(),
+                format(e, k).c_str());
+  }
+  return 0;
+}
@@ -0,0 +1,458 @@
+/*
+ * propgen: generates model headers from a schema file.
+ *
+ * Usage: propgen <schema.prop> -o <header.hpp>
+ *
+ * A schema holds any amount of models, optionally preceded by a namespace and
+ * extra includes:
+ *
+ *   namespace shapes;
+ *   include <vector>;
+ *
+ *   model point {
+ *     double x = 0;
+ *     double y = 0;
+ *     std::string label;
+ *   }
+ *
+ * Each model becomes a struct with one `properties::property<T>` member per
+ * field, backed by a storage struct whose fields are ordered by decreasing
+ * alignment. See the generated code for the rest of the interface.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+struct field {
+  std::string type;
+  std::string name;
+  std::string init;
+  std::size_t index;
+};
+
+struct model {
+  std::string name;
+  std::vector<field> fields;
+};
+
+struct schema {
+  std::string ns;
+  std::vector<std::string> includes;
+  std::vector<model> models;
+};
+
+struct error {
+  std::size_t line;
+  std::string message;
+};
+
+const std::set<std::string> reserved = {
+    "field_count", "fields",      "data",        "dirty",
+    "pending",     "batch_depth", "changes",     "clear_changes",
+    "begin_batch", "end_batch",   "diff",        "apply",
+    "serialize",   "deserialize", "for_each_field", "subscribe",
+    "changed",     "storage",     "_changed"};
+
+std::string trim(const std::string &s) {
+  auto begin = s.find_first_not_of(" \t\r");
+  if (begin == std::string::npos)
+    return "";
+  auto end = s.find_last_not_of(" \t\r");
+  return s.substr(begin, end - begin + 1);
+}
+
+bool is_identifier(const std::string &s) {
+  if (s.empty() || std::isdigit((unsigned char)s[0]))
+    return false;
+  return std::all_of(s.begin(), s.end(), [](char c) {
+    return std::isalnum((unsigned char)c) || c == '_';
+  });
+}
+
+bool is_qualified_name(const std::string &s) {
+  std::size_t start = 0;
+  for (;;) {
+    auto sep = s.find("::", start);
+    if (!is_identifier(s.substr(start, sep - start)))
+      return false;
+    if (sep == std::string::npos)
+      return true;
+    start = sep + 2;
+  }
+}
+
+// Alignment class of a field type; unknown (class) types go first.
+int alignment_rank(const std::string &type) {
+  static const std::map<std::string, int> known = {
+      {"bool", 1},           {"char", 1},          {"signed char", 1},
+      {"unsigned char", 1},  {"std::int8_t", 1},   {"std::uint8_t", 1},
+      {"int8_t", 1},         {"uint8_t", 1},       {"short", 2},
+      {"unsigned short", 2}, {"std::int16_t", 2},  {"std::uint16_t", 2},
+      {"int16_t", 2},        {"uint16_t", 2},      {"char16_t", 2},
+      {"int", 4},            {"unsigned", 4},      {"unsigned int", 4},
+      {"float", 4},          {"std::int32_t", 4},  {"std::uint32_t", 4},
+      {"int32_t", 4},        {"uint32_t", 4},      {"char32_t", 4},
+      {"long", 8},           {"unsigned long", 8}, {"long long", 8},
+      {"double", 8},         {"std::size_t", 8},   {"std::int64_t", 8},
+      {"std::uint64_t", 8},  {"int64_t", 8},       {"uint64_t", 8},
+      {"unsigned long long", 8}};
+  auto it = known.find(type);
+  if (it != known.end())
+    return it->second;
+  return type.back() == '*' ? 8 : 16;
+}
+
+// Splits "type name = init" (without the trailing semicolon).
+field parse_field(const std::string &text, std::size_t line) {
+  field f;
+  std::string decl = text;
+  int depth = 0;
+  for (std::size_t i = 0; i < text.size(); i++) {
+    if (text[i] == '<' || text[i] == '(' || text[i] == '{')
+      depth++;
+    else if (text[i] == '>' || text[i] == ')' || text[i] == '}')
+      depth--;
+    else if (text[i] == '=' && depth == 0) {
+      decl = text.substr(0, i);
+      f.init = trim(text.substr(i + 1));
+      if (f.init.empty())
+        throw error{line, "missing default value"};
+      break;
+    }
+  }
+  decl = trim(decl);
+  auto split = decl.find_last_of(" \t*&");
+  if (split == std::string::npos)
+    throw error{line, "expected '<type> <name>'"};
+  f.name = decl.substr(split + 1);
+  f.type = trim(decl.substr(0, decl[split] == ' ' || decl[split] == '\t'
+                                   ? split
+                                   : split + 1));
+  if (!is_identifier(f.name))
+    throw error{line, "invalid field name '" + f.name + "'"};
+  if (f.type.empty())
+    throw error{line, "missing type for field '" + f.name + "'"};
+  bool ends_in_bit =
+      f.name.size() > 4 && f.name.compare(f.name.size() - 4, 4, "_bit") == 0;
+  if (reserved.count(f.name) != 0 || ends_in_bit)
+    throw error{line, "field name '" + f.name + "' is reserved"};
+  return f;
+}
+
+// finds the start of a '#' or '//' comment, skipping quoted literals
+std::size_t comment_start(const std::string &s) {
+  char quote = 0;
+  for (std::size_t i = 0; i < s.size(); i++) {
+    char c = s[i];
+    if (quote != 0) {
+      if (c == '\\')
+        i++;
+      else if (c == quote)
+        quote = 0;
+    } else if (c == '"' || c == '\'') {
+      quote = c;
+    } else if (c == '#' || (c == '/' && i + 1 < s.size() && s[i + 1] == '/')) {
+      return i;
+    }
+  }
+  return std::string::npos;
+}
+
+schema parse(std::istream &in) {
+  schema result;
+  model *current = nullptr;
+  std::string raw;
+  std::size_t line = 0;
+  std::set<std::string> names;
+
+  while (std::getline(in, raw)) {
+    line++;
+    auto comment = comment_start(raw);
+    std::string text = trim(raw.substr(0, comment));
+    if (text.empty())
+      continue;
+
+    if (current == nullptr) {
+      if (text.rfind("namespace ", 0) == 0 && text.back() == ';') {
+        result.ns = trim(text.substr(10, text.size() - 11));
+        if (!is_qualified_name(result.ns))
+          throw error{line, "invalid namespace '" + result.ns + "'"};
+      } else if (text.rfind("include ", 0) == 0 && text.back() == ';') {
+        result.includes.push_back(trim(text.substr(8, text.size() - 9)));
+      } else if (text.rfind("model ", 0) == 0 && text.back() == '{') {
+        result.models.push_back({trim(text.substr(6, text.size() - 7)), {}});
+        current = &result.models.back();
+        if (!is_identifier(current->name))
+          throw error{line, "invalid model name '" + current->name + "'"};
+        names.clear();
+      } else {
+        throw error{line, "expected 'namespace', 'include' or 'model'"};
+      }
+    } else if (text == "}") {
+      if (current->fields.empty())
+        throw error{line, "model '" + current->name + "' has no fields"};
+      current = nullptr;
+    } else {
+      if (text.back() != ';')
+        throw error{line, "expected ';' after field"};
+      field f = parse_field(text.substr(0, text.size() - 1), line);
+      if (!names.insert(f.name).second)
+        throw error{line, "duplicate field '" + f.name + "'"};
+      f.index = current->fields.size();
+      if (f.index == 64)
+        throw error{line, "a model can hold at most 64 fields"};
+      current->fields.push_back(f);
+    }
+  }
+
+  if (current != nullptr)
+    throw error{line, "missing '}' after model '" + current->name + "'"};
+  return result;
+}
+
+std::string quote(const std::string &s) {
+  std::string result = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\')
+      result += '\\';
+    result += c;
+  }
+  return result + "\"";
+}
+
+void generate_model(std::ostream &out, const model &m) {
+  const auto &fs = m.fields;
+  std::vector<field> packed = fs;
+  std::stable_sort(packed.begin(), packed.end(),
+                   [](const field &a, const field &b) {
+                     return alignment_rank(a.type) > alignment_rank(b.type);
+                   });
+
+  out << "/**\n *  @brief Generated model " << m.name << ".\n */\n";
+  out << "struct " << m.name << " {\n";
+  out << "public:\n";
+  out << "  /** @brief The amount of fields. */\n";
+  out << "  static constexpr std::size_t field_count = " << fs.size()
+      << ";\n\n";
+  out << "  /** @brief Change mask bits, one per field. */\n";
+  out << "  enum : properties::change_mask {\n";
+  for (const auto &f : fs)
+    out << "    " << f.name << "_bit = properties::change_mask{1} << "
+        << f.index << ",\n";
+  out << "  };\n\n";
+  out << "  /** @brief The field table, in declaration order. */\n";
+  out << "  static constexpr properties::field_info fields[field_count] = {\n";
+  for (const auto &f : fs)
+    out << "      {" << quote(f.name) << ", " << quote(f.type) << ", "
+        << f.index << ", " << f.name << "_bit},\n";
+  out << "  };\n\n";
+
+  out << "private:\n";
+  out << "  struct storage {\n";
+  for (const auto &f : packed) {
+    out << "    " << f.type << " " << f.name;
+    if (!f.init.empty())
+      out << " = " << f.init;
+    else
+      out << "{}";
+    out << ";\n";
+  }
+  out << "  };\n\n";
+  out << "  storage data;\n";
+  out << "  properties::change_mask dirty = 0;\n";
+  out << "  properties::change_mask pending = 0;\n";
+  out << "  unsigned batch_depth = 0;\n";
+  out << "  properties::event<properties::change_mask> _changed;\n\n";
+
+  out << "public:\n";
+  for (const auto &f : fs) {
+    out << "  /** @brief The " << f.name << " field. */\n";
+    out << "  properties::property<" << f.type << "> " << f.name << "{data."
+        << f.name << "};\n";
+  }
+  out << "\n";
+
+  out << "  /**\n   *  @brief Creates a model holding the default values.\n"
+         "   */\n";
+  out << "  " << m.name << "() { subscribe(); }\n";
+  out << "  /**\n   *  @brief You can't copy a model; use `apply()` "
+         "instead.\n   */\n";
+  out << "  " << m.name << "(const " << m.name << " &) = delete;\n\n";
+
+  out << "  /**\n   *  @brief Gets the fields changed since the last "
+         "`clear_changes()`.\n   *  @return The change mask.\n   */\n";
+  out << "  properties::change_mask changes() const { return dirty; }\n";
+  out << "  /**\n   *  @brief Forgets all changes.\n   */\n";
+  out << "  void clear_changes() { dirty = 0; }\n\n";
+
+  out << "  /**\n   *  @brief Starts a batch.\n   *  @details Until the "
+         "matching `end_batch()`, field changes are collected\n   * instead "
+         "of triggering the model event one by one.\n   */\n";
+  out << "  void begin_batch() { batch_depth++; }\n";
+  out << "  /**\n   *  @brief Ends a batch.\n   *  @details When the "
+         "outermost batch ends, the model event is triggered\n   * once with "
+         "the mask of all fields changed during the batch.\n   */\n";
+  out << "  void end_batch() {\n";
+  out << "    if (--batch_depth == 0 && pending != 0) {\n";
+  out << "      properties::change_mask mask = pending;\n";
+  out << "      pending = 0;\n";
+  out << "      _changed.trigger(mask);\n";
+  out << "    }\n";
+  out << "  }\n\n";
+
+  out << "  /**\n   *  @brief Compares the fields of two models.\n"
+         "   *  @return The mask of fields that differ.\n   */\n";
+  out << "  properties::change_mask diff(const " << m.name
+      << " &other) const {\n";
+  out << "    properties::change_mask mask = 0;\n";
+  for (const auto &f : fs)
+    out << "    if (!(data." << f.name << " == other.data." << f.name
+        << "))\n      mask |= " << f.name << "_bit;\n";
+  out << "    return mask;\n";
+  out << "  }\n\n";
+
+  out << "  /**\n   *  @brief Copies fields from another model in one "
+         "batch.\n   *\n   *  @param other The model to copy from.\n"
+         "   *  @param mask The fields to copy.\n   */\n";
+  out << "  void apply(const " << m.name
+      << " &other,\n             properties::change_mask mask = "
+         "~properties::change_mask{0}) {\n";
+  out << "    begin_batch();\n";
+  for (const auto &f : fs)
+    out << "    if (mask & " << f.name << "_bit)\n      " << f.name
+        << ".set(other.data." << f.name << ");\n";
+  out << "    end_batch();\n";
+  out << "  }\n\n";
+
+  out << "  /**\n   *  @brief Appends the fields to a buffer.\n"
+         "   *\n   *  @param out The buffer to append to.\n   */\n";
+  out << "  void serialize(std::string &out) const {\n";
+  for (const auto &f : fs)
+    out << "    properties::serializer<" << f.type << ">::write(out, data."
+        << f.name << ");\n";
+  out << "  }\n\n";
+
+  out << "  /**\n   *  @brief Reads all fields from a buffer in one batch.\n"
+         "   *  @details Only fields whose value differs are set. Nothing is "
+         "set if the\n   * buffer is invalid.\n   *\n"
+         "   *  @param in The buffer to read from.\n"
+         "   *  @return True if the buffer held exactly one model.\n   */\n";
+  out << "  bool deserialize(std::string_view in) {\n";
+  out << "    storage next;\n";
+  out << "    if (";
+  for (std::size_t i = 0; i < fs.size(); i++)
+    out << (i == 0 ? "" : " ||\n        ") << "!properties::serializer<"
+        << fs[i].type << ">::read(in, next." << fs[i].name << ")";
+  out << " ||\n        !in.empty())\n      return false;\n";
+  out << "    begin_batch();\n";
+  for (const auto &f : fs)
+    out << "    if (!(next." << f.name << " == data." << f.name << "))\n      "
+        << f.name << ".set(next." << f.name << ");\n";
+  out << "    end_batch();\n";
+  out << "    return true;\n";
+  out << "  }\n\n";
+
+  out << "  /**\n   *  @brief Calls a function for each field.\n"
+         "   *  @details The function is called with the `field_info` and the "
+         "property of\n   * each field, in declaration order.\n"
+         "   *\n   *  @param func The function to call.\n   */\n";
+  out << "  template <typename F> void for_each_field(F &&func) {\n";
+  for (const auto &f : fs)
+    out << "    func(fields[" << f.index << "], " << f.name << ");\n";
+  out << "  }\n\n";
+
+  out << "  /**\n   *  @brief Adds a callback to the model event.\n"
+         "   *  @details The callback is called with the mask of changed "
+         "fields: once per\n   * field change, or once per batch.\n"
+         "   *\n   * @param callback The callback to add to the event.\n"
+         "   */\n";
+  out << "  void operator+(\n      typename properties::event<"
+         "properties::change_mask>::Callable callback) {\n";
+  out << "    _changed + callback;\n";
+  out << "  }\n\n";
+
+  out << "private:\n";
+  out << "  void subscribe() {\n";
+  for (const auto &f : fs)
+    out << "    " << f.name << " + [this](" << f.type << " &) { changed("
+        << f.name << "_bit); };\n";
+  out << "  }\n\n";
+  out << "  void changed(properties::change_mask bit) {\n";
+  out << "    dirty |= bit;\n";
+  out << "    if (batch_depth > 0)\n";
+  out << "      pending |= bit;\n";
+  out << "    else\n";
+  out << "      _changed.trigger(bit);\n";
+  out << "  }\n";
+  out << "};\n\n";
+}
+
+std::string guard_for(const std::string &path) {
+  auto slash = path.find_last_of('/');
+  std::string base = path.substr(slash == std::string::npos ? 0 : slash + 1);
+  std::string guard = "_PROP_GEN_";
+  for (char c : base)
+    guard += std::isalnum((unsigned char)c) ? (char)std::toupper(c) : '_';
+  return guard;
+}
+
+void generate(std::ostream &out, const schema &s, const std::string &input,
+              const std::string &output) {
+  std::string guard = guard_for(output);
+  out << "// Generated by propgen from " << input << "; do not edit.\n";
+  out << "#ifndef " << guard << "\n#define " << guard << "\n\n";
+  out << "#include \"event.hpp\"\n#include \"model.hpp\"\n"
+         "#include \"property.hpp\"\n#include \"serialize.hpp\"\n\n";
+  out << "#include <cstddef>\n#include <string>\n#include <string_view>\n";
+  for (const auto &inc : s.includes)
+    out << "#include " << inc << "\n";
+  out << "\n";
+  if (!s.ns.empty())
+    out << "namespace " << s.ns << " {\n";
+  for (const auto &m : s.models)
+    generate_model(out, m);
+  if (!s.ns.empty())
+    out << "} // namespace " << s.ns << "\n\n";
+  out << "#endif /* " << guard << " */\n";
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc != 4 || std::string(argv[2]) != "-o") {
+    std::cerr << "usage: " << argv[0] << " <schema.prop> -o <header.hpp>\n";
+    return 2;
+  }
+  std::string input = argv[1];
+  std::string output = argv[3];
+
+  std::ifstream in(input);
+  if (!in) {
+    std::cerr << input << ": cannot open file\n";
+    return 1;
+  }
+
+  schema s;
+  try {
+    s = parse(in);
+  } catch (const error &e) {
+    std::cerr << input << ":" << e.line << ": error: " << e.message << "\n";
+    return 1;
+  }
+
+  std::ostringstream code;
+  generate(code, s, input, output);
+  std::ofstream out(output);
+  if (!(out << code.str())) {
+    std::cerr << output << ": cannot write file\n";
+    return 1;
+  }
+  return 0;
+}